@@ -72,6 +72,47 @@ bool assetman_initFont(SDL_Renderer* renderer, const char* assetPath, float heig
     return fontLoaded;
 }
 
+struct OpeningBook* assetman_loadBook(const char* assetPath)
+{
+    struct OpeningBook* loadedBook = NULL;
+    if(assetPak)
+    {
+        PakEntryData entry = PAK_LoadEntry(assetPak, assetPath);
+        if(entry.data)
+            loadedBook = gamebook_load(entry.data, entry.size);
+        PAK_CloseEntry(&entry);
+    }
+    return loadedBook;
+}
+
+struct Tablebase* assetman_loadTablebase(const char* assetPath)
+{
+    struct Tablebase* loadedTablebase = NULL;
+    if(assetPak)
+    {
+        PakEntryData entry = PAK_LoadEntry(assetPak, assetPath);
+        if(entry.data)
+            loadedTablebase = gametablebase_open(entry.data, entry.size);
+        // The tablebase keeps the entry data on success
+        if(!loadedTablebase)
+            PAK_CloseEntry(&entry);
+    }
+    return loadedTablebase;
+}
+
+bool assetman_loadEvalWeights(const char* assetPath, struct EvalWeights* weights)
+{
+    bool loaded = false;
+    if(assetPak)
+    {
+        PakEntryData entry = PAK_LoadEntry(assetPak, assetPath);
+        if(entry.data)
+            loaded = gameeval_loadWeights(weights, entry.data, entry.size);
+        PAK_CloseEntry(&entry);
+    }
+    return loaded;
+}
+
 void assetman_stop(void)
 {
     if(assetPak)
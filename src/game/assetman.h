@@ -2,6 +2,9 @@
 #include <stdbool.h>
 #include <SDL2/SDL.h>
 #include "../utils/wavplayer.h"
+#include "../states/game/gamebook.h"
+#include "../states/game/gametablebase.h"
+#include "../states/game/gameeval.h"
 
 /// @brief Initalize asset manager by giving it the path of a PAK file
 /// @param pakPath PAK asset file path
@@ -31,5 +34,21 @@ WavInfo* assetman_loadWav(const char* assetPath);
 /// @return true on success, false on failure
 bool assetman_initFont(SDL_Renderer* renderer, const char* assetPath, float height);
 
+/// @brief Load an opening book from loaded PAK file
+/// @param assetPath Book file path inside the PAK file
+/// @return Opening book on success (has to be freed with gamebook_free), NULL on failure
+struct OpeningBook* assetman_loadBook(const char* assetPath);
+
+/// @brief Load a tablebase from loaded PAK file, the entries are searched in the loaded file data
+/// @param assetPath Tablebase file path inside the PAK file
+/// @return Tablebase on success (has to be freed with gametablebase_free), NULL on failure
+struct Tablebase* assetman_loadTablebase(const char* assetPath);
+
+/// @brief Load position evaluation weights from loaded PAK file
+/// @param assetPath Weights file path inside the PAK file
+/// @param weights Weights to write
+/// @return true on success, false on failure (the weights aren't changed then)
+bool assetman_loadEvalWeights(const char* assetPath, struct EvalWeights* weights);
+
 // Closes the PAK file and stops the asset manager
 void assetman_stop(void);
@@ -3,8 +3,10 @@
 #include "save.h"
 #include "fade.h"
 #include "assetman.h"
+#include "../states/game/gameai.h"
 #include "../utils/timer.h"
 #include "../utils/rendertext.h"
+#include "../utils/random.h"
 #include <time.h>
 
 //PSP RTC tick functions are more accurate on that platform than SDL2 PerformanceCounter
@@ -38,6 +40,13 @@ struct KASettings gameSettings;
 
 bool launchedTutorial = false;
 
+// Random number generator used to derive the seeds of subsystem generators
+static KRandom seedRandom;
+
+// Seed set by game_setSeed, valid if seedSet is true
+static uint64_t startSeed;
+static bool seedSet = false;
+
 static struct KAMessage messageData;
 
 static Uint64 getTimeTicks(void)
@@ -68,6 +77,7 @@ static void initSettings(void)
     gameSettings.player2Type = 3;
     gameSettings.player3Type = 0;
     gameSettings.player4Type = 0;
+    gameSettings.explosionMode = 0;
 }
 
 /// @brief Checks if there are at least 2 players configured in the settings
@@ -83,10 +93,11 @@ static void clampSettings(void)
 {
     int gridWidth = SDL_clamp(gameSettings.gridWidth, MIN_GRIDWIDTH, MAX_GRIDWIDTH);
     int gridHeight = SDL_clamp(gameSettings.gridHeight, MIN_GRIDHEIGHT, MAX_GRIDHEIGHT);
-    gameSettings.player1Type = SDL_clamp(gameSettings.player1Type, 0, 4);
-    gameSettings.player2Type = SDL_clamp(gameSettings.player2Type, 0, 4);
-    gameSettings.player3Type = SDL_clamp(gameSettings.player3Type, 0, 4);
-    gameSettings.player4Type = SDL_clamp(gameSettings.player4Type, 0, 4);
+    gameSettings.player1Type = SDL_clamp(gameSettings.player1Type, 0, 6);
+    gameSettings.player2Type = SDL_clamp(gameSettings.player2Type, 0, 6);
+    gameSettings.player3Type = SDL_clamp(gameSettings.player3Type, 0, 6);
+    gameSettings.player4Type = SDL_clamp(gameSettings.player4Type, 0, 6);
+    gameSettings.explosionMode = SDL_clamp(gameSettings.explosionMode, 0, 1);
     if(!isEnoughPlayers())
         initSettings();
     gameSettings.gridWidth = gridWidth;
@@ -175,6 +186,8 @@ static SDL_GameControllerButton mapKeyboardToGamepad(SDL_Keycode key)
             return SDL_CONTROLLER_BUTTON_DPAD_DOWN;
         case SDLK_RETURN:
             return SDL_CONTROLLER_BUTTON_START;
+        case SDLK_TAB:
+            return SDL_CONTROLLER_BUTTON_BACK;
         default:
             return SDL_CONTROLLER_BUTTON_INVALID;
     }
@@ -235,6 +248,17 @@ bool game_init(void)
         return false;
     }
 
+    // The AI searches every move without the opening book, so it's optional
+    aiBook = assetman_loadBook("game/openings.bin");
+    if(!aiBook)
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,"Couldn't load the opening book resources.pak/game/openings.bin");
+    if(!assetman_loadEvalWeights("game/evalweights.bin", &aiEvalWeights))
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,"Couldn't load the evaluation weights resources.pak/game/evalweights.bin, using the built-in weights");
+    // The tablebase isn't packed by default, a tablebase generated by kleleatoms-tablebase can be packed as game/tablebase.bin
+    aiTablebase = assetman_loadTablebase("game/tablebase.bin");
+    if(!aiTablebase)
+        SDL_Log("No tablebase in resources.pak/game/tablebase.bin");
+
     if(!initSounds())
     {
         game_errorMsg("Couldn't load sounds!");
@@ -245,7 +269,10 @@ bool game_init(void)
     loadSettings();
     clampSettings();
 
-    srand(time(NULL));
+    if(!seedSet)
+        startSeed = (uint64_t)time(NULL);
+    krandom_seed(&seedRandom, startSeed);
+    SDL_Log("Random seed: %llu",(unsigned long long)startSeed);
 
     loadStates();
     changeStateInstant(ST_MENUSTATE);
@@ -253,6 +280,18 @@ bool game_init(void)
     return true;
 }
 
+void game_setSeed(uint64_t seed)
+{
+    startSeed = seed;
+    seedSet = true;
+}
+
+uint64_t game_newSeed(void)
+{
+    uint64_t seed = krandom_next(&seedRandom);
+    return (seed << 32) | krandom_next(&seedRandom);
+}
+
 void game_loop(void)
 {
     fade_doFadeIn(0.25f, (SDL_Color){0,0,0,SDL_ALPHA_TRANSPARENT});
@@ -370,6 +409,11 @@ void game_errorMsg(const char* format, ...)
 void game_quit(void)
 {
     destroySounds();
+    ai_Quit();
+    gamebook_free(aiBook);
+    aiBook = NULL;
+    gametablebase_free(aiTablebase);
+    aiTablebase = NULL;
     rendertext_stop();
     assetman_stop();
     IMG_Quit();
@@ -1,6 +1,7 @@
 #pragma once
 #include <SDL2/SDL.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "../utils/wavplayer.h"
 
 #ifndef STR
@@ -39,6 +40,7 @@ struct KASettings {
     int player2Type;
     int player3Type;
     int player4Type;
+    int explosionMode;  //Chain reaction propagation mode (ExplosionMode enum from gamelogic.h)
 };
 
 extern struct KASettings gameSettings;
@@ -46,6 +48,14 @@ extern struct KASettings gameSettings;
 // If true, the game state is launched in tutorial mode, otherwise it's in normal mode
 extern bool launchedTutorial;
 
+/// @brief Set the seed every random number generator seed is derived from (used before game_init, the current time is used otherwise)
+/// @param seed Seed value
+void game_setSeed(uint64_t seed);
+
+/// @brief Get a new seed for a subsystem random number generator, derived from the game_setSeed seed
+/// @return Seed value
+uint64_t game_newSeed(void);
+
 /// @brief Initialize the game and all subsystems
 /// @return true on success, false on failure
 bool game_init(void);
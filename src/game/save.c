@@ -37,6 +37,7 @@ void loadSettings(void)
         gameSettings.player2Type = SDL_ReadU8(file);
         gameSettings.player3Type = SDL_ReadU8(file);
         gameSettings.player4Type = SDL_ReadU8(file);
+        gameSettings.explosionMode = SDL_ReadU8(file); //0 (sequential) in settings files saved before it was added
         SDL_RWclose(file);
     }
 }
@@ -52,6 +53,7 @@ void saveSettings(void)
         SDL_WriteU8(file, gameSettings.player2Type & 0xFF);
         SDL_WriteU8(file, gameSettings.player3Type & 0xFF);
         SDL_WriteU8(file, gameSettings.player4Type & 0xFF);
+        SDL_WriteU8(file, gameSettings.explosionMode & 0xFF);
         SDL_RWclose(file);
     }
 }
@@ -78,19 +80,15 @@ static void loadPlayerStatus(int playerNum, Uint8 playerStatus)
     {
         case 0:
             logicData->playerStatus[playerNum] = PST_LOST;
-            logicData->playerAtoms[playerNum] = 0;
             break;
         case 1:
             logicData->playerStatus[playerNum] = PST_NOTSTARTED;
-            logicData->playerAtoms[playerNum] = 0;
             break;
         case 2:
             logicData->playerStatus[playerNum] = PST_PLAYING;
-            logicData->playerAtoms[playerNum] = 1;
             break;
         default:
             logicData->playerStatus[playerNum] = PST_NOTPRESENT;
-            logicData->playerAtoms[playerNum] = 0;
             break;
     }
 }
@@ -102,7 +100,7 @@ static void loadPlayerStatus(int playerNum, Uint8 playerStatus)
 static void loadAIType(int playerNum, Uint8 val, Uint8 difficulty)
 {
     aiDifficulty[playerNum] = 0;
-    val = SDL_min(val,4);
+    val = SDL_min(val,6);
     if(val == 0)
     {
         aiPlayer[playerNum] = false;
@@ -158,16 +156,14 @@ int loadGame(void)
             closeLoadedSaveFile(file);
             return -2;
         }
-        //Grid size check
-        if(gridWidth > MAX_GRID_WIDTH || gridHeight > MAX_GRID_HEIGHT)
+        //Grid size check (the grid has to fit on the screen)
+        if(gridWidth > MAX_GRIDWIDTH || gridHeight > MAX_GRIDHEIGHT || !gamelogic_setGridSize(gridWidth, gridHeight))
         {
-            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"loadGame: Save file grid is too big! (%d x %d), max is %d x %d",gridWidth,gridHeight,MAX_GRID_WIDTH,MAX_GRID_HEIGHT);
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"loadGame: Save file grid size is invalid! (%d x %d), max is %d x %d",gridWidth,gridHeight,MAX_GRIDWIDTH,MAX_GRIDHEIGHT);
             closeLoadedSaveFile(file);
             return -2;
         }
         //Parse the rest of header if last check succeeded
-        logicData->gridWidth = gridWidth;
-        logicData->gridHeight = gridHeight;
         temp = SDL_ReadU8(file); logicData->totalPlayerCount = SDL_min(temp,4);
         temp = SDL_ReadU8(file); logicData->curPlayerCount = SDL_min(temp,4);
         Uint8 aiDifficulty = SDL_ReadU8(file); aiDifficulty = SDL_clamp(aiDifficulty,1,3);
@@ -188,13 +184,10 @@ int loadGame(void)
                 if(player > 3) //Remove tile data with invalid player number
                     atomCount = 0;
                 gamelogic_setAtoms(x,y,player,atomCount);
-                logicData->critGrid[x][y] = 4;
-                if(x == 0 || x == gridWidth-1)
-                    logicData->critGrid[x][y]--;
-                if(y == 0 || y == gridHeight-1)
-                    logicData->critGrid[x][y]--;
             }
         }
+        //Explosion mode is stored after the tile data, 0 (sequential) in save files saved before it was added
+        temp = SDL_ReadU8(file); logicData->board.explosionMode = (temp == EXPLOSION_WAVE) ? EXPLOSION_WAVE : EXPLOSION_SEQUENTIAL;
         ai_Init();
         closeLoadedSaveFile(file);
         return loadedTime;
@@ -246,6 +239,17 @@ bool saveGame(void)
         return false;
     }
 
+    // KSF stores tile atom counts as single bytes, don't write a save that would lose atoms
+    for(int i=0; i<logicData->gridWidth*logicData->gridHeight; i++)
+    {
+        if(logicData->board.count[i] > UINT8_MAX)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"saveGame: Tile %d has %u atoms, KSF can only store %d!",i,(unsigned)logicData->board.count[i],UINT8_MAX);
+            game_printMsg("Couldn't save the game!",3);
+            return false;
+        }
+    }
+
     SDL_RWops* file = SDL_RWFromFile(saveFilePath,"wb");
     if(file)
     {
@@ -272,11 +276,13 @@ bool saveGame(void)
         {
             for(int y=0; y<logicData->gridHeight; y++)
             {
-                struct KATile* curTile = &logicData->tiles[x][y];
-                SDL_WriteU8(file, (curTile->playerNum + 1) & 0xFF);
-                SDL_WriteU8(file, (curTile->atomCount) & 0xFF);
+                int index = BOARD_INDEX(&logicData->board,x,y);
+                int owner = logicData->board.owner[index];
+                SDL_WriteU8(file, (owner == NOOWNER) ? 0 : ((owner + 1) & 0xFF));
+                SDL_WriteU8(file, logicData->board.count[index]);
             }
         }
+        SDL_WriteU8(file, logicData->board.explosionMode & 0xFF);
         SDL_RWclose(file);
     }
     else
@@ -1,6 +1,9 @@
 #pragma once
 #include <stdbool.h>
 
+// File path to the KSF save file
+extern const char* saveFilePath;
+
 // Load settings (without bounds checking)
 void loadSettings(void);
 
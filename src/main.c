@@ -1,7 +1,29 @@
 #include "game/game.h"
+#include "states/game/gameai.h"
+#include <stdlib.h>
+#include <string.h>
 
 int main(int argc, char** argv)
 {
+    for(int i=1; i<argc; i++)
+    {
+        // --seed <number> makes every game reproducible
+        if(strcmp(argv[i],"--seed") == 0 && i+1 < argc)
+            game_setSeed(strtoull(argv[++i],NULL,0));
+        // --threads <number> sets the amount of AI search threads (0 = one per CPU core)
+        else if(strcmp(argv[i],"--threads") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiThreadCount = SDL_max(value,0);
+        }
+        // --table-size <megabytes> sets the transposition table size of the difficulty 4 AI (0 = no table)
+        else if(strcmp(argv[i],"--table-size") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiTableSize = SDL_max(value,0);
+        }
+    }
+
     if(!game_init())
         return 1;
 
@@ -1,19 +1,18 @@
 #include "gameai.h"
 #include "gamelogic.h"
-#include "../../game/state.h"
-#include "../../game/game.h"
 #include "../../utils/timer.h"
 #include <stdlib.h>
+#include <string.h>
 
-// Tile data used by the AI algorithm
+// Tile data used by the AI algorithm (every tile array has space for all the grid tiles)
 struct AITiles {
-    Vec2 tiles[MAX_GRID_WIDTH*MAX_GRID_HEIGHT]; //Every valid tile
+    Vec2* tiles; //Every valid tile
     int tileCount;
-    Vec2 notAvoidTiles[MAX_GRID_WIDTH*MAX_GRID_HEIGHT]; //Every tile that doesn't have to be avoided by AI (difficulty 2+)
+    Vec2* notAvoidTiles; //Every tile that doesn't have to be avoided by AI (difficulty 2+)
     int naTileCount;
-    Vec2 advTiles[MAX_GRID_WIDTH*MAX_GRID_HEIGHT]; //Every tile where the AI has a possible advantage over other players (difficulty 3)
+    Vec2* advTiles; //Every tile where the AI has a possible advantage over other players (difficulty 3)
     int advTileCount;
-    Vec2 specTiles[MAX_GRID_WIDTH*MAX_GRID_HEIGHT]; //Every tile the AI should focus on the most (difficulty 2+)
+    Vec2* specTiles; //Every tile the AI should focus on the most (difficulty 2+)
     int specTileCount;
     Vec2 cornerTiles[4]; //Every corner tile the AI should focus on the most (difficulty 3)
     int cornerTileCount;
@@ -24,89 +23,274 @@ struct AITiles {
     int* secondaryTileCount;
 };
 
+// Tile features used by the difficulty 2 and 3 AI
+enum AIFeature {
+    AIFEATURE_PRECRIT = 1,      //A nearby enemy tile is 1 atom away from exploding
+    AIFEATURE_ADVANTAGE = 2,    //The tile is at least as close to exploding as a nearby enemy tile
+    AIFEATURE_ATOMSNEARBY = 4,  //A nearby tile has atoms
+    AIFEATURE_OPENCORNER = 8    //The tile is an undefended corner (see aiCornerCheck)
+};
+
+// Features of every tile for every player, kept between moves. Only the tiles around the tiles changed by moves and explosions are recomputed (see ai_TileChanged).
+struct AIFeatureIndex {
+    bool valid;             //Are the features built for the current game (every tile is recomputed if not)
+    int gridWidth;          //Grid size the index is allocated for
+    int gridHeight;
+    uint8_t* features;      //AIFeature flags, indexed by tile index*4+player
+    bool* dirty;            //Is the tile queued for recomputing
+    int* dirtyTiles;        //Indices of the tiles queued for recomputing
+    int dirtyTileCount;
+    struct AITiles* tiles;  //Tile lists reused by every move
+};
+
+// Move search of the difficulty 4 and 5 AI (or pondering of the difficulty 5 AI) running on a worker thread
+struct AIJob {
+    SDL_Thread* thread;                 //Worker thread (NULL if the search ran on the main thread)
+    bool pondering;                     //Is the job searching during a human player turn (no move is made)
+    int difficulty;                     //AI difficulty (4 or 5)
+    int player;                         //Player the move is searched for
+    struct KABoard board;               //Board snapshot taken when the search was started
+    enum PlayerStatus playerStatus[4];  //Player status snapshot
+    Vec2* moveHints;                    //Moves searched first by the difficulty 4 AI
+    int moveHintCount;
+    struct MCTSTree* tree;              //Search tree of the difficulty 5 AI
+    KRandom random;                     //Generator forked from the game generator for the playouts of the difficulty 5 AI
+    SDL_atomic_t cancel;                //Set to 1 by the main thread to stop the search early
+    SDL_atomic_t mailbox;               //Selected tile index + 1 written once by the worker (AIMAILBOX_EMPTY while the search is running)
+};
+
+// AI state of games played without the game state (see ai_findMove)
+struct AIContext {
+    struct AIFeatureIndex features;     //Tile features of the difficulty 2 and 3 AI (also used for the difficulty 4 AI move hints)
+    struct KABoard board;               //Board of the previous ai_findMove call, the features of the tiles changed since then are recomputed
+    struct TransTable* table;           //Transposition table of the difficulty 4 AI (NULL = no table)
+};
+
+// Mailbox value of a running search
+#define AIMAILBOX_EMPTY 0
+// Mailbox value of a failed search
+#define AIMAILBOX_FAILED -1
+
 // AI Move Delay in milliseconds
 #define AIDELAY 300
 
+// Default max search depth of the difficulty 4 AI in plies
+#define AISEARCHDEPTH 8
+
+// Default time budget of the difficulty 4 AI in milliseconds
+#define AISEARCHTIME 200
+
+// Default time budget of the difficulty 5 AI in milliseconds
+#define AIMCTSTIME AIDELAY
+
+// Default UCT exploration constant of the difficulty 5 AI
+#define AIMCTSEXPLORATION 0.7f
+
+// Max amount of playouts made by pondering during a single human turn (about one tree node per playout)
+#define AIPONDERPLAYOUTS MCTS_MAX_NODES
+
+// Known move value of a turn the tablebase and the book weren't probed for yet
+#define AIKNOWNMOVE_UNPROBED -2
+
+// Max amount of moves remembered for the kept search tree, the tree is rebuilt if more moves are made before it's used again
+#define AIMAXPLAYEDMOVES 8
+
+// Default amount of search threads (0 = one per CPU core), the PSP has a single core
+// Default transposition table size of the difficulty 4 AI in megabytes, the PSP has only a few megabytes to spare
+#ifdef __PSP__
+#define AITHREADS 1
+#define AITABLESIZE 1
+#else
+#define AITHREADS 0
+#define AITABLESIZE 64
+#endif
+
 // Timer for AI movement delays
 static KTimer* aiTimer = NULL;
 
-// Array with positions diagonally neighboring with corner tiles (non-corner tiles are unused)
-static Vec2 cornerCheckTab[MAX_GRID_WIDTH][MAX_GRID_HEIGHT];
+// Search running on the worker thread or NULL
+static struct AIJob* aiJob = NULL;
+
+// Search tree of the difficulty 5 AI kept between moves (NULL while a job is using it)
+static struct MCTSTree* aiTree = NULL;
+
+// Moves made since the root position of the kept search tree
+static Vec2 aiPlayedMoves[AIMAXPLAYEDMOVES];
+static int aiPlayedMoveCount = 0;
+
+// Was pondering already started during the current turn
+static bool aiPonderStarted = false;
+
+// Tablebase or book move of the current turn (-1 = neither has one), probed once when the AI starts thinking
+static int aiKnownMove = AIKNOWNMOVE_UNPROBED;
+
+// Tile features of the difficulty 2 and 3 AI
+static struct AIFeatureIndex aiFeatures;
+
+// Thread pool shared by the difficulty 4 and 5 AI searches (NULL if the search uses a single thread)
+static KThreadPool* aiThreadPool = NULL;
+
+// Transposition table of the difficulty 4 AI kept between moves (NULL if it couldn't be allocated)
+static struct TransTable* aiTable = NULL;
+
+struct OpeningBook* aiBook = NULL;
+
+struct Tablebase* aiTablebase = NULL;
+
+struct EvalWeights aiEvalWeights = EVAL_DEFAULT_WEIGHTS;
+
+int aiThreadCount = AITHREADS;
+
+int aiMoveDelay = AIDELAY;
+
+bool aiWorkerThread = true;
+
+int aiTableSize = AITABLESIZE;
+
+bool aiPondering = true;
 
 bool aiPlayer[4];
 
 int aiDifficulty[4];
 
+struct AISearchParams aiSearchParams = {AISEARCHDEPTH, AISEARCHTIME, NULL, NULL, NULL, &aiEvalWeights};
+
+struct AIMCTSParams aiMCTSParams = {AIMCTSTIME, 0, AIMCTSEXPLORATION, NULL};
+
+/// @brief Get the player owning the atoms on a given tile
+/// @param board Board
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @return Tile player number or NOPLAYER if the tile is empty
+static int aiGetTilePlayer(const struct KABoard* board, int x, int y)
+{
+    uint8_t owner = board->owner[BOARD_INDEX(board,x,y)];
+    return (owner == NOOWNER) ? NOPLAYER : owner;
+}
+
+/// @brief Get the amount of atoms on a given tile
+/// @param board Board
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @return Tile atom count
+static int aiGetTileAtoms(const struct KABoard* board, int x, int y)
+{
+    return board->count[BOARD_INDEX(board,x,y)];
+}
+
+/// @brief Get the critical atom amount of a given tile
+/// @param board Board
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @return Tile critical atom amount
+static int aiGetTileCrit(const struct KABoard* board, int x, int y)
+{
+    return 4 - (x == 0 || x == board->gridWidth-1) - (y == 0 || y == board->gridHeight-1);
+}
+
+/// @brief Get the position diagonally neighboring with a corner tile
+/// @param gridWidth Grid width
+/// @param gridHeight Grid height
+/// @param x Corner tile X position
+/// @param y Corner tile Y position
+/// @return Diagonal tile position (clamped to the grid)
+static Vec2 aiGetCornerDiagonal(int gridWidth, int gridHeight, int x, int y)
+{
+    Vec2 diagPos;
+    diagPos.x = (x == 0) ? SDL_min(1,gridWidth-1) : x-1;
+    diagPos.y = (y == 0) ? SDL_min(1,gridHeight-1) : y-1;
+    return diagPos;
+}
+
 /// @brief Checks if tile on a given position belongs to another player
+/// @param board Board
 /// @param x Tile X position
 /// @param y Tile Y position
+/// @param player Player the check is made for
 /// @return true if tile belongs to another player, false otherwise
-static bool aiIsTileEnemy(int x, int y)
+static bool aiIsTileEnemy(const struct KABoard* board, int x, int y, int player)
 {
-    int playerNum = logicData->tiles[x][y].playerNum;
-    return (playerNum != NOPLAYER && playerNum != logicData->curPlayer);
+    int playerNum = aiGetTilePlayer(board,x,y);
+    return (playerNum != NOPLAYER && playerNum != player);
 }
 
-/// @brief Get the amount of corners the current player has atoms on
-/// @param max_x Max valid X position (width-1)
-/// @param max_y Max valid Y position (height-1)
-/// @return The amount of corners the current player has atoms on
-static int aiGetCorners(int max_x, int max_y)
+/// @brief Checks if a tile is in a corner of the grid
+/// @param board Board
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @return true if the tile is a corner tile
+static bool aiIsCorner(const struct KABoard* board, int x, int y)
 {
+    return ((x == 0 || x == board->gridWidth-1) && (y == 0 || y == board->gridHeight-1));
+}
+
+/// @brief Get the amount of corners a player has atoms on
+/// @param board Board
+/// @param player Player number
+/// @return The amount of corners the player has atoms on
+static int aiGetCorners(const struct KABoard* board, int player)
+{
+    int max_x = board->gridWidth-1;
+    int max_y = board->gridHeight-1;
     int cornerCount = 0;
-    if(logicData->tiles[0][0].playerNum == logicData->curPlayer)
+    if(aiGetTilePlayer(board,0,0) == player)
         cornerCount++;
-    if(logicData->tiles[max_x][0].playerNum == logicData->curPlayer)
+    if(aiGetTilePlayer(board,max_x,0) == player)
         cornerCount++;
-    if(logicData->tiles[0][max_y].playerNum == logicData->curPlayer)
+    if(aiGetTilePlayer(board,0,max_y) == player)
         cornerCount++;
-    if(logicData->tiles[max_x][max_y].playerNum == logicData->curPlayer)
+    if(aiGetTilePlayer(board,max_x,max_y) == player)
         cornerCount++;
     return cornerCount;
 }
 
 /// @brief Checks if there are any atoms nearby
+/// @param board Board
 /// @param nearbyTiles Array of nearby tiles generated by getNearbyTiles
 /// @param nearbyTileCount Amount of nearby tiles
 /// @return true if there are atoms, false if not
-static bool aiAtomsNearby(Vec2* nearbyTiles, int nearbyTileCount)
+static bool aiAtomsNearby(const struct KABoard* board, Vec2* nearbyTiles, int nearbyTileCount)
 {
     for(int i=0; i<nearbyTileCount; i++)
     {
         int x = nearbyTiles[i].x;
         int y = nearbyTiles[i].y;
-        if(logicData->tiles[x][y].atomCount > 0)
+        if(aiGetTileAtoms(board,x,y) > 0)
             return true;
     }
     return false;
 }
 
 /// @brief Checks if player has any atom advantage over another player on this tile
+/// @param board Board
 /// @param nearbyTiles Array of nearby tiles generated by getNearbyTiles
 /// @param nearbyTileCount Amount of nearby tiles
 /// @param patoms Difference between current atom count and critical amount
+/// @param player Player the check is made for
 /// @return true if there are's an advantage, false if not
-static bool aiCheckAdvantage(Vec2* nearbyTiles, int nearbyTileCount, int patoms)
+static bool aiCheckAdvantage(const struct KABoard* board, Vec2* nearbyTiles, int nearbyTileCount, int patoms, int player)
 {
     for(int i=0; i<nearbyTileCount; i++)
     {
         int x = nearbyTiles[i].x;
         int y = nearbyTiles[i].y;
-        if(aiIsTileEnemy(x,y) && (patoms >= logicData->tiles[x][y].atomCount-logicData->critGrid[x][y]))
+        if(aiIsTileEnemy(board,x,y,player) && (patoms >= aiGetTileAtoms(board,x,y)-aiGetTileCrit(board,x,y)))
             return true;
     }
     return false;
 }
 
-/// @brief Check if enemy or the current player has an undefended corner (1 atom on every side near the corner and no 2 atom tile diagonally from the corner)
+/// @brief Check if enemy or the given player has an undefended corner (1 atom on every side near the corner and no 2 atom tile diagonally from the corner)
+/// @param board Board
 /// @param basex Checked corner tile X position
 /// @param basey Checked corner tile Y position
 /// @param nearbyTiles Array of nearby tiles generated by getNearbyTiles
 /// @param nearbyTileCount Amount of nearby tiles
+/// @param player Player the check is made for
 /// @return True if check succeeded, false if not
-static bool aiCornerCheck(int basex, int basey, Vec2* nearbyTiles, int nearbyTileCount)
+static bool aiCornerCheck(const struct KABoard* board, int basex, int basey, Vec2* nearbyTiles, int nearbyTileCount, int player)
 {
-    if(logicData->critGrid[basex][basey] > 2)
+    if(aiGetTileCrit(board,basex,basey) > 2)
         return false;
 
     int ccval = 0;
@@ -115,58 +299,218 @@ static bool aiCornerCheck(int basex, int basey, Vec2* nearbyTiles, int nearbyTil
     {
         int x = nearbyTiles[i].x;
         int y = nearbyTiles[i].y;
-        struct KATile* curTile = &logicData->tiles[x][y];
-        if(curTile->playerNum != NOPLAYER && patoms >= curTile->atomCount-logicData->critGrid[x][y])
+        if(aiGetTilePlayer(board,x,y) != NOPLAYER && patoms >= aiGetTileAtoms(board,x,y)-aiGetTileCrit(board,x,y))
             ccval++;
     }
-    int cposx = cornerCheckTab[basex][basey].x;
-    int cposy = cornerCheckTab[basex][basey].y;
-    if(aiIsTileEnemy(cposx,cposy) && (logicData->tiles[basex][basey].atomCount == logicData->tiles[cposx][cposy].atomCount-2))
+    Vec2 cornerDiagonal = aiGetCornerDiagonal(board->gridWidth,board->gridHeight,basex,basey);
+    int cposx = cornerDiagonal.x;
+    int cposy = cornerDiagonal.y;
+    if(aiIsTileEnemy(board,cposx,cposy,player) && (aiGetTileAtoms(board,basex,basey) == aiGetTileAtoms(board,cposx,cposy)-2))
         return false;
     return (ccval >= 2);
 }
 
-/// @brief Check if any nearby tiles are 1 atom away from exploding
+/// @brief Check if any nearby enemy tiles are 1 atom away from exploding
+/// @param board Board
 /// @param nearbyTiles Array of nearby tiles generated by getNearbyTiles
 /// @param nearbyTileCount Amount of nearby tiles
+/// @param player Player the check is made for
 /// @return True if the check succeeded, false if not
-static bool aiCheckPreCrit(Vec2* nearbyTiles, int nearbyTileCount)
+static bool aiCheckPreCrit(const struct KABoard* board, Vec2* nearbyTiles, int nearbyTileCount, int player)
 {
     for(int i=0; i<nearbyTileCount; i++)
     {
         int x = nearbyTiles[i].x;
         int y = nearbyTiles[i].y;
-        if(aiIsTileEnemy(x,y) && (logicData->tiles[x][y].atomCount >= logicData->critGrid[x][y]-1))
+        if(aiIsTileEnemy(board,x,y,player) && (aiGetTileAtoms(board,x,y) >= aiGetTileCrit(board,x,y)-1))
             return true;
     }
     return false;
 }
 
 /// @brief Get an array of nearby tile positions
+/// @param gridWidth Grid width
+/// @param gridHeight Grid height
 /// @param x Base tile X position
 /// @param y Base tile Y position
 /// @param _nearbyTiles Pointer to an array to write the positions to
 /// @return Amount of nearby tiles
-static int getNearbyTiles(int x, int y, Vec2 (*_nearbyTiles)[4])
+static int getNearbyTiles(int gridWidth, int gridHeight, int x, int y, Vec2 (*_nearbyTiles)[4])
 {
     Vec2* nearbyTiles = *_nearbyTiles;
     int nearbyTileCount = 0;
     if(y > 0)
         nearbyTiles[nearbyTileCount++] = (Vec2){x,y-1};
-    if(y < logicData->gridHeight-1)
+    if(y < gridHeight-1)
         nearbyTiles[nearbyTileCount++] = (Vec2){x,y+1};
     if(x > 0)
         nearbyTiles[nearbyTileCount++] = (Vec2){x-1,y};
-    if(x < logicData->gridWidth-1)
+    if(x < gridWidth-1)
         nearbyTiles[nearbyTileCount++] = (Vec2){x+1,y};
     return nearbyTileCount;
 }
 
+/// @brief Compute the feature flags of a tile
+/// @param board Board
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @param player Player the features are computed for
+/// @return AIFeature flags
+static uint8_t aiGetTileFeatures(const struct KABoard* board, int x, int y, int player)
+{
+    Vec2 nearbyTiles[4];
+    int nearbyTileCount = getNearbyTiles(board->gridWidth,board->gridHeight,x,y,&nearbyTiles);
+    uint8_t features = 0;
+    if(aiCheckPreCrit(board,nearbyTiles,nearbyTileCount,player))
+        features |= AIFEATURE_PRECRIT;
+    if(aiCheckAdvantage(board,nearbyTiles,nearbyTileCount,aiGetTileAtoms(board,x,y)-aiGetTileCrit(board,x,y),player))
+        features |= AIFEATURE_ADVANTAGE;
+    if(aiAtomsNearby(board,nearbyTiles,nearbyTileCount))
+        features |= AIFEATURE_ATOMSNEARBY;
+    if(aiIsCorner(board,x,y) && aiCornerCheck(board,x,y,nearbyTiles,nearbyTileCount,player))
+        features |= AIFEATURE_OPENCORNER;
+    return features;
+}
+
+/// @brief Allocate the AI tile data for a grid size
+/// @param tileCount Amount of grid tiles
+/// @return AITiles struct or NULL if the allocation failed
+static struct AITiles* aiAllocTiles(int tileCount)
+{
+    struct AITiles* tiles = calloc(1,sizeof(struct AITiles));
+    if(!tiles)
+        return NULL;
+    // All tile arrays share a single allocation
+    tiles->tiles = malloc(4*tileCount*sizeof(Vec2));
+    if(!tiles->tiles)
+    {
+        free(tiles);
+        return NULL;
+    }
+    tiles->notAvoidTiles = tiles->tiles+tileCount;
+    tiles->advTiles = tiles->notAvoidTiles+tileCount;
+    tiles->specTiles = tiles->advTiles+tileCount;
+    return tiles;
+}
+
+/// @brief Free the AI tile data allocated by aiAllocTiles
+/// @param tiles AITiles struct (can be NULL)
+static void aiFreeTiles(struct AITiles* tiles)
+{
+    if(!tiles)
+        return;
+    free(tiles->tiles);
+    free(tiles);
+}
+
+/// @brief Free a feature index, it's allocated again by the next aiUpdateFeatures call
+/// @param featureIndex Feature index
+static void aiFreeFeatures(struct AIFeatureIndex* featureIndex)
+{
+    free(featureIndex->features);
+    free(featureIndex->dirty);
+    free(featureIndex->dirtyTiles);
+    aiFreeTiles(featureIndex->tiles);
+    *featureIndex = (struct AIFeatureIndex){0};
+}
+
+/// @brief Queue a tile of a feature index for recomputing
+/// @param featureIndex Feature index
+/// @param x Tile X position
+/// @param y Tile Y position
+static void aiMarkTile(struct AIFeatureIndex* featureIndex, int x, int y)
+{
+    int index = y*featureIndex->gridWidth+x;
+    if(featureIndex->dirty[index])
+        return;
+    featureIndex->dirty[index] = true;
+    featureIndex->dirtyTiles[featureIndex->dirtyTileCount++] = index;
+}
+
+/// @brief Queue a changed tile and the tiles depending on it for recomputing
+/// @param featureIndex Feature index
+/// @param x Tile X position
+/// @param y Tile Y position
+static void aiMarkChangedTile(struct AIFeatureIndex* featureIndex, int x, int y)
+{
+    // The features of a tile depend on the tile itself and the nearby tiles, corner tiles also depend on their diagonal tile
+    int gridWidth = featureIndex->gridWidth;
+    int gridHeight = featureIndex->gridHeight;
+    aiMarkTile(featureIndex,x,y);
+    Vec2 nearbyTiles[4];
+    int nearbyTileCount = getNearbyTiles(gridWidth,gridHeight,x,y,&nearbyTiles);
+    for(int i=0; i<nearbyTileCount; i++)
+        aiMarkTile(featureIndex,nearbyTiles[i].x,nearbyTiles[i].y);
+    Vec2 corners[4] = {{0,0},{gridWidth-1,0},{0,gridHeight-1},{gridWidth-1,gridHeight-1}};
+    for(int i=0; i<4; i++)
+    {
+        Vec2 cornerDiagonal = aiGetCornerDiagonal(gridWidth,gridHeight,corners[i].x,corners[i].y);
+        if(cornerDiagonal.x == x && cornerDiagonal.y == y)
+            aiMarkTile(featureIndex,corners[i].x,corners[i].y);
+    }
+}
+
+/// @brief Recompute the features of the tiles changed since the last call, the whole index is (re)built for a new game or grid size
+/// @param featureIndex Feature index
+/// @param board Board the features are computed on
+/// @return true on success, false on allocation failure
+static bool aiUpdateFeatures(struct AIFeatureIndex* featureIndex, const struct KABoard* board)
+{
+    int gridWidth = board->gridWidth;
+    int gridHeight = board->gridHeight;
+    int tileCount = gridWidth*gridHeight;
+    if(!featureIndex->tiles || featureIndex->gridWidth != gridWidth || featureIndex->gridHeight != gridHeight)
+    {
+        aiFreeFeatures(featureIndex);
+        featureIndex->features = malloc(tileCount*4*sizeof(uint8_t));
+        featureIndex->dirty = calloc(tileCount,sizeof(bool));
+        featureIndex->dirtyTiles = malloc(tileCount*sizeof(int));
+        featureIndex->tiles = aiAllocTiles(tileCount);
+        if(!featureIndex->features || !featureIndex->dirty || !featureIndex->dirtyTiles || !featureIndex->tiles)
+        {
+            aiFreeFeatures(featureIndex);
+            return false;
+        }
+        featureIndex->gridWidth = gridWidth;
+        featureIndex->gridHeight = gridHeight;
+    }
+    if(!featureIndex->valid)
+    {
+        for(int x=0; x<gridWidth; x++)
+        {
+            for(int y=0; y<gridHeight; y++)
+                aiMarkTile(featureIndex,x,y);
+        }
+        featureIndex->valid = true;
+    }
+
+    for(int i=0; i<featureIndex->dirtyTileCount; i++)
+    {
+        int index = featureIndex->dirtyTiles[i];
+        for(int player=0; player<4; player++)
+            featureIndex->features[index*4+player] = aiGetTileFeatures(board, index % gridWidth, index / gridWidth, player);
+        featureIndex->dirty[index] = false;
+    }
+    featureIndex->dirtyTileCount = 0;
+    return true;
+}
+
 /// @brief Run the AI algorithm and give the possible tiles for AI to place atom on
-/// @param difficulty AI difficulty for current player
-/// @param tiles AITiles struct used by the function, contains the possible move tiles in primaryTiles and secondaryTiles variables
-static void aiGetSpecialTiles(int difficulty, struct AITiles* tiles)
+/// @param featureIndex Feature index of the board
+/// @param board Board
+/// @param player Player the tiles are picked for
+/// @param difficulty AI difficulty of the player
+/// @return AITiles struct of the feature index, contains the possible move tiles in primaryTiles and secondaryTiles variables (NULL on allocation failure)
+static struct AITiles* aiGetSpecialTiles(struct AIFeatureIndex* featureIndex, const struct KABoard* board, int player, int difficulty)
 {
+    if(!aiUpdateFeatures(featureIndex, board))
+        return NULL;
+    struct AITiles* tiles = featureIndex->tiles;
+    tiles->tileCount = 0;
+    tiles->naTileCount = 0;
+    tiles->advTileCount = 0;
+    tiles->specTileCount = 0;
+    tiles->cornerTileCount = 0;
     tiles->primaryTiles = tiles->specTiles;
     tiles->primaryTileCount = &tiles->specTileCount;
     tiles->secondaryTiles = tiles->tiles;
@@ -174,29 +518,29 @@ static void aiGetSpecialTiles(int difficulty, struct AITiles* tiles)
 
     bool wasSpCorner = false;
     bool wasAdvCorner = false;
-    int gridWidth = logicData->gridWidth;
-    int gridHeight = logicData->gridHeight;
-    int cornerCount = aiGetCorners(gridWidth-1, gridHeight-1);
+    int gridWidth = board->gridWidth;
+    int gridHeight = board->gridHeight;
+    int cornerCount = aiGetCorners(board, player);
     for(int x=0; x<gridWidth; x++)
     {
         for(int y=0; y<gridHeight; y++)
         {
-            struct KATile* curTile = &logicData->tiles[x][y];
+            int tilePlayer = aiGetTilePlayer(board,x,y);
+            int tileAtoms = aiGetTileAtoms(board,x,y);
             Vec2 curPos = {x,y};
-            if(curTile->playerNum == logicData->curPlayer || curTile->playerNum == NOPLAYER)
+            if(tilePlayer == player || tilePlayer == NOPLAYER)
             {
-                Vec2 nearbyTiles[4];
-                int nearbyTileCount = getNearbyTiles(x,y,&nearbyTiles);
-                int curCritAmount = logicData->critGrid[x][y];
+                uint8_t features = featureIndex->features[BOARD_INDEX(board,x,y)*4+player];
+                int curCritAmount = aiGetTileCrit(board,x,y);
                 bool isSpTile = false;
                 bool tileAvoided = false;
                 tiles->tiles[tiles->tileCount++] = curPos;
                 tiles->notAvoidTiles[tiles->naTileCount++] = curPos;
                 if(difficulty == 2)
                 {
-                    if(aiCheckPreCrit(nearbyTiles,nearbyTileCount))
+                    if(features & AIFEATURE_PRECRIT)
                     {
-                        if(curTile->atomCount == (curCritAmount - 1))
+                        if(tileAtoms == (curCritAmount - 1))
                         {
                             tiles->specTiles[tiles->specTileCount++] = curPos;
                             isSpTile = true;
@@ -210,15 +554,15 @@ static void aiGetSpecialTiles(int difficulty, struct AITiles* tiles)
                 }
                 else if(difficulty == 3)
                 {
-                    bool isCorner = ((x == 0 || x == gridWidth-1) && (y == 0 || y == gridHeight-1));
-                    if(isCorner && curTile->atomCount == 1 && !aiAtomsNearby(nearbyTiles,nearbyTileCount))
+                    bool isCorner = aiIsCorner(board,x,y);
+                    if(isCorner && tileAtoms == 1 && !(features & AIFEATURE_ATOMSNEARBY))
                     {
                         tiles->naTileCount--;
                         tileAvoided = true;
                     }
-                    else if(aiCheckPreCrit(nearbyTiles,nearbyTileCount))
+                    else if(features & AIFEATURE_PRECRIT)
                     {
-                        if(curTile->atomCount == (curCritAmount - 1))
+                        if(tileAtoms == (curCritAmount - 1))
                         {
                             tiles->specTiles[tiles->specTileCount++] = curPos;
                             isSpTile = true;
@@ -229,10 +573,8 @@ static void aiGetSpecialTiles(int difficulty, struct AITiles* tiles)
                             tileAvoided = true;
                         }
                     }
-                    bool isAdvantage = false;
-                    if(!isSpTile)
-                        isAdvantage = aiCheckAdvantage(nearbyTiles, nearbyTileCount, curTile->atomCount-curCritAmount);
-                    if(!tileAvoided && isCorner && (cornerCount == 0 || aiCornerCheck(x,y,nearbyTiles,nearbyTileCount)))
+                    bool isAdvantage = !isSpTile && (features & AIFEATURE_ADVANTAGE);
+                    if(!tileAvoided && isCorner && (cornerCount == 0 || (features & AIFEATURE_OPENCORNER)))
                     {
                         if(wasSpCorner && isSpTile)
                         {
@@ -260,7 +602,7 @@ static void aiGetSpecialTiles(int difficulty, struct AITiles* tiles)
                                 wasAdvCorner = true;
                             }
 
-                            if(curTile->atomCount == 0 || isSpTile || isAdvantage)
+                            if(tileAtoms == 0 || isSpTile || isAdvantage)
                                 tiles->cornerTiles[tiles->cornerTileCount++] = curPos;
                         }
                     }
@@ -288,33 +630,273 @@ static void aiGetSpecialTiles(int difficulty, struct AITiles* tiles)
         tiles->secondaryTiles = tiles->notAvoidTiles;
         tiles->secondaryTileCount = &tiles->naTileCount;
     }
+    return tiles;
+}
+
+/// @brief Shuffle an array of tiles
+/// @param tiles Tile array
+/// @param tileCount Amount of tiles
+/// @param random Random number generator
+static void aiShuffleTiles(Vec2* tiles, int tileCount, KRandom* random)
+{
+    for(int i=tileCount-1; i>0; i--)
+    {
+        int j = krandom_range(random,i+1);
+        Vec2 temp = tiles[i];
+        tiles[i] = tiles[j];
+        tiles[j] = temp;
+    }
+}
+
+/// @brief Pick a random tile from the AI algorithm recommended tiles, primary tiles are picked before secondary tiles
+/// @param tiles AITiles struct given by aiGetSpecialTiles
+/// @param random Random number generator used to pick the tile
+/// @return Picked tile position or {-1,-1} if there are no tiles
+static Vec2 aiPickTile(struct AITiles* tiles, KRandom* random)
+{
+    int spTileCount = *tiles->primaryTileCount;
+    int tileCount = *tiles->secondaryTileCount;
+    if(spTileCount > 0)
+        return tiles->primaryTiles[krandom_range(random,spTileCount)];
+    if(tileCount > 0)
+        return tiles->secondaryTiles[krandom_range(random,tileCount)];
+    return (Vec2){-1,-1};
+}
+
+/// @brief Collect the tiles recommended by the difficulty 3 algorithm as move hints for the alpha-beta search (difficulty 4)
+/// @param featureIndex Feature index of the board
+/// @param board Board
+/// @param player Player the move is searched for
+/// @param random Random number generator used to pick between equally good moves
+/// @param moveHintCount Amount of hints to write
+/// @return Move hints (have to be freed) or NULL on allocation failure
+static Vec2* aiGetSearchHints(struct AIFeatureIndex* featureIndex, const struct KABoard* board, int player, KRandom* random, int* moveHintCount)
+{
+    struct AITiles* tiles = aiGetSpecialTiles(featureIndex, board, player, 3);
+    if(!tiles)
+        return NULL;
+    int primaryCount = *tiles->primaryTileCount;
+    int secondaryCount = *tiles->secondaryTileCount;
+    Vec2* moveHints = malloc(SDL_max(primaryCount+secondaryCount,1)*sizeof(Vec2));
+    if(moveHints)
+    {
+        // The search keeps the first of equally scored moves, so shuffling picks a random one of them
+        aiShuffleTiles(tiles->primaryTiles, primaryCount, random);
+        aiShuffleTiles(tiles->secondaryTiles, secondaryCount, random);
+        memcpy(moveHints, tiles->primaryTiles, primaryCount*sizeof(Vec2));
+        memcpy(moveHints+primaryCount, tiles->secondaryTiles, secondaryCount*sizeof(Vec2));
+        *moveHintCount = primaryCount+secondaryCount;
+    }
+    return moveHints;
+}
+
+/// @brief Search a move on the job snapshot with the alpha-beta search (difficulty 4) or the Monte Carlo tree search (difficulty 5) and post it to the job mailbox
+/// @param data AI job
+/// @return Always 0
+static int aiWorker(void* data)
+{
+    struct AIJob* job = data;
+    bool found = false;
+    // The main thread keeps rendering and handling input while the search runs
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    Vec2 move;
+    if(job->difficulty == 4)
+    {
+        struct AISearchParams params = aiSearchParams;
+        params.cancel = &job->cancel;
+        params.threadPool = aiThreadPool;
+        params.table = aiTable;
+        struct AISearchResult result;
+        found = gamesearch_findMove(&job->board, job->player, job->playerStatus, job->moveHints, job->moveHintCount, &params, &result);
+        if(found)
+        {
+            move = result.move;
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,"AI 4: depth %d, %ld positions, score %d, table hit rate %.1f%% (%ld of %ld)",result.depth,result.nodes,result.score,
+                (result.tableProbes > 0) ? 100.0f*result.tableHits/result.tableProbes : 0.0f,result.tableHits,result.tableProbes);
+        }
+    }
+    else
+    {
+        struct AIMCTSParams params = aiMCTSParams;
+        params.cancel = &job->cancel;
+        params.threadPool = aiThreadPool;
+        if(job->pondering)
+        {
+            params.timeLimit = 0;
+            params.maxPlayouts = AIPONDERPLAYOUTS;
+        }
+        struct AIMCTSResult result;
+        found = gamemcts_search(job->tree, &params, &job->random, &result);
+        if(found)
+        {
+            move = result.move;
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,"AI 5%s: %ld playouts in %d ms (%ld playouts/s), %ld playouts reused, %d nodes, win rate %.2f",job->pondering ? " pondering" : "",
+                result.playouts,(int)result.timeMillis,result.playoutsPerSecond,result.reusedPlayouts,result.nodes,result.winRate);
+        }
+    }
+    SDL_AtomicSet(&job->mailbox, found ? BOARD_INDEX(&job->board,move.x,move.y)+1 : AIMAILBOX_FAILED);
+    return 0;
+}
+
+/// @brief Wait for the worker thread to finish and free the AI job, the search tree is kept for the next job
+/// @param job AI job
+static void aiFreeJob(struct AIJob* job)
+{
+    if(job->thread)
+        SDL_WaitThread(job->thread, NULL);
+    if(job->tree)
+    {
+        gamemcts_freeTree(aiTree);
+        aiTree = job->tree;
+    }
+    gamelogic_freeBoard(&job->board);
+    free(job->moveHints);
+    free(job);
+}
+
+/// @brief Take the kept search tree and move its root along the moves made since it was used, or create a new tree
+/// @return Search tree or NULL on allocation failure
+static struct MCTSTree* aiTakeTree(void)
+{
+    struct MCTSTree* tree = aiTree;
+    aiTree = NULL;
+    if(tree && aiPlayedMoveCount > AIMAXPLAYEDMOVES)
+    {
+        gamemcts_freeTree(tree);
+        tree = NULL;
+    }
+    if(tree)
+    {
+        for(int i=0; i<aiPlayedMoveCount; i++)
+            gamemcts_playMove(tree, aiPlayedMoves[i].x, aiPlayedMoves[i].y);
+        // Clears the tree if the moves didn't lead to the current position for some reason
+        gamemcts_setRoot(tree, &logicData->board, logicData->curPlayer, logicData->playerStatus);
+    }
+    else
+    {
+        tree = gamemcts_createTree(&logicData->board, logicData->curPlayer, logicData->playerStatus);
+    }
+    aiPlayedMoveCount = 0;
+    return tree;
+}
+
+/// @brief Take a snapshot of the game and start searching a move on the worker thread (difficulty 4 and 5)
+/// @param random Game random number generator, the job gets its own generator seeded from it
+/// @param pondering Search with the difficulty 5 AI during a human player turn without making a move
+/// @return true on success, false on allocation failure
+static bool aiStartJob(KRandom* random, bool pondering)
+{
+    struct AIJob* job = calloc(1,sizeof(struct AIJob));
+    if(!job)
+        return false;
+    job->pondering = pondering;
+    job->difficulty = pondering ? 5 : aiDifficulty[logicData->curPlayer];
+    job->player = logicData->curPlayer;
+    memcpy(job->playerStatus, logicData->playerStatus, sizeof(job->playerStatus));
+    uint64_t seed = (uint64_t)krandom_next(random) << 32;
+    seed |= krandom_next(random);
+    krandom_seed(&job->random, seed);
+    SDL_AtomicSet(&job->mailbox, AIMAILBOX_EMPTY);
+    if(!gamelogic_getBoard(&job->board) || (job->difficulty == 4 && !(job->moveHints = aiGetSearchHints(&aiFeatures, &logicData->board, job->player, random, &job->moveHintCount)))
+        || (job->difficulty == 5 && !(job->tree = aiTakeTree())))
+    {
+        aiFreeJob(job);
+        return false;
+    }
+
+    job->thread = aiWorkerThread ? SDL_CreateThread(aiWorker, "AI", job) : NULL;
+    if(!job->thread && pondering)
+    {
+        aiFreeJob(job);
+        return false;
+    }
+    if(!job->thread && !aiWorkerThread)
+    {
+        aiWorker(job);
+    }
+    else if(!job->thread)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"AI: Couldn't create the AI thread, searching on the main thread instead! (%s)",SDL_GetError());
+        aiWorker(job);
+    }
+    aiJob = job;
+    return true;
+}
+
+/// @brief Check the job mailbox and make the move once the worker has posted it
+static void aiCheckJob(void)
+{
+    int message = SDL_AtomicGet(&aiJob->mailbox);
+    if(message == AIMAILBOX_EMPTY)
+        return;
+    int gridWidth = aiJob->board.gridWidth;
+    aiFreeJob(aiJob);
+    aiJob = NULL;
+    if(message == AIMAILBOX_FAILED)
+    {
+        gamelogic_errorMsg("No Available AI Tiles for player %d",logicData->curPlayer);
+        return;
+    }
+    gamelogic_clickedTile((message-1) % gridWidth, (message-1) / gridWidth, true);
 }
 
-// Runs the AI algorithm and clicks a random tile from the AI algorithm recommended tiles
-static void aiThinker(void)
+/// @brief Get a move of the current position that doesn't need a search, a winning tablebase move or a book move
+/// @return Tile index of the move or -1 if the position is in neither of them
+static int aiGetKnownMove(void)
+{
+    int move;
+    // Lost tablebase positions are still searched, the opponent may not play perfectly
+    if(gametablebase_probe(aiTablebase, &logicData->board, logicData->playerStatus, logicData->curPlayer, &move) == TB_WIN)
+    {
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,"AI %d: tablebase move",aiDifficulty[logicData->curPlayer]);
+        return move;
+    }
+    move = gamebook_probe(aiBook, &logicData->board, logicData->playerStatus, logicData->curPlayer);
+    if(move >= 0)
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,"AI %d: book move",aiDifficulty[logicData->curPlayer]);
+    return move;
+}
+
+/// @brief Runs the AI algorithm and clicks a random tile from the AI algorithm recommended tiles, the difficulty 4 and 5 AI start a search on the worker thread instead
+/// @param random Random number generator used to pick the tile
+static void aiThinker(KRandom* random)
 {
     Vec2 selectedTile = (Vec2){-1,-1};
     if(aiDifficulty[logicData->curPlayer] <= 3)
     {
-        struct AITiles* tiles = calloc(1,sizeof(struct AITiles));
-        aiGetSpecialTiles(aiDifficulty[logicData->curPlayer],tiles);
-        int spTileCount = *tiles->primaryTileCount;
-        int tileCount = *tiles->secondaryTileCount;
-        if(spTileCount > 0)
-            selectedTile = tiles->primaryTiles[rand() % spTileCount];
-        else if(tileCount > 0)
-            selectedTile = tiles->secondaryTiles[rand() % tileCount];
-        free(tiles);
+        struct AITiles* tiles = aiGetSpecialTiles(&aiFeatures, &logicData->board, logicData->curPlayer, aiDifficulty[logicData->curPlayer]);
+        if(!tiles)
+        {
+            gamelogic_errorMsg("AI: Couldn't allocate tile data for a %d x %d grid!",logicData->gridWidth,logicData->gridHeight);
+            return;
+        }
+        selectedTile = aiPickTile(tiles, random);
+    }
+    else if(aiDifficulty[logicData->curPlayer] <= 5)
+    {
+        // The difficulty 5 AI thinks on every tick of the move delay, the position doesn't change in the meantime
+        if(aiKnownMove == AIKNOWNMOVE_UNPROBED)
+            aiKnownMove = aiGetKnownMove();
+        if(aiKnownMove < 0)
+        {
+            if(!aiStartJob(random, false))
+                gamelogic_errorMsg("AI: Couldn't allocate search data for a %d x %d grid!",logicData->gridWidth,logicData->gridHeight);
+            return;
+        }
+        // Known moves don't need a search, so the difficulty 5 AI waits for the move delay like the other difficulties
+        if(ktimer_getTimeMillis(aiTimer) < aiMoveDelay)
+            return;
+        selectedTile = (Vec2){aiKnownMove % logicData->gridWidth, aiKnownMove / logicData->gridWidth};
     }
     else
     {
-        game_errorMsg("Incorrect AI difficulty - %d",aiDifficulty[logicData->curPlayer]);
+        gamelogic_errorMsg("Incorrect AI difficulty - %d",aiDifficulty[logicData->curPlayer]);
         return;
     }
 
     if(selectedTile.x == -1)
     {
-        game_errorMsg("No Available AI Tiles for player %d",logicData->curPlayer);
+        gamelogic_errorMsg("No Available AI Tiles for player %d",logicData->curPlayer);
         return;
     }
     gamelogic_clickedTile(selectedTile.x, selectedTile.y, true);
@@ -322,24 +904,217 @@ static void aiThinker(void)
 
 void ai_Init(void)
 {
-    int gridw = logicData->gridWidth;
-    int gridh = logicData->gridHeight;
+    aiFeatures.valid = false;
+    aiKnownMove = AIKNOWNMOVE_UNPROBED;
     if(!aiTimer)
         aiTimer = ktimer_create();
-    memset(cornerCheckTab, 0, sizeof(cornerCheckTab));
-    cornerCheckTab[0][0] = (Vec2){1,1};
-    cornerCheckTab[0][gridh-1] = (Vec2){1,gridh-2};
-    cornerCheckTab[gridw-1][0] = (Vec2){gridw-2,1};
-    cornerCheckTab[gridw-1][gridh-1] = (Vec2){gridw-2,gridh-2};
+
+    // The thread pool and the transposition table are only kept while a game has a player using them
+    bool searchPlayer = false;
+    bool tablePlayer = false;
+    for(int i=0; i<4; i++)
+    {
+        if(!aiPlayer[i] || logicData->playerStatus[i] == PST_NOTPRESENT)
+            continue;
+        searchPlayer |= (aiDifficulty[i] >= 4);
+        tablePlayer |= (aiDifficulty[i] == 4);
+    }
+    int threadCount = (aiThreadCount > 0) ? aiThreadCount : SDL_GetCPUCount();
+    if(!searchPlayer || threadCount <= 1)
+    {
+        kthreadpool_destroy(aiThreadPool);
+        aiThreadPool = NULL;
+    }
+    else if(!aiThreadPool)
+    {
+        aiThreadPool = kthreadpool_create(threadCount);
+        if(!aiThreadPool)
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"ai_Init: Couldn't create the AI thread pool, searching on a single thread instead!");
+    }
+    if(!tablePlayer || aiTableSize <= 0)
+    {
+        gametranstable_free(aiTable);
+        aiTable = NULL;
+    }
+    else if(!aiTable)
+    {
+        aiTable = gametranstable_create((size_t)aiTableSize*1024*1024);
+        if(!aiTable)
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"ai_Init: Couldn't allocate a %d MB transposition table, searching without it instead!",aiTableSize);
+    }
+}
+
+void ai_Quit(void)
+{
+    ai_Cancel();
+    kthreadpool_destroy(aiThreadPool);
+    aiThreadPool = NULL;
+    gametranstable_free(aiTable);
+    aiTable = NULL;
+    aiFreeFeatures(&aiFeatures);
+    ktimer_destroy(aiTimer);
+    aiTimer = NULL;
+}
+
+void ai_TileChanged(int x, int y)
+{
+    // An invalid index is rebuilt from scratch by the next lookup anyway
+    if(!aiFeatures.valid || aiFeatures.gridWidth != logicData->gridWidth || aiFeatures.gridHeight != logicData->gridHeight)
+        return;
+    aiMarkChangedTile(&aiFeatures, x, y);
 }
 
 void ai_ResetTime(void)
 {
     ktimer_setTimeMillis(aiTimer, 0);
+    aiPonderStarted = false;
+    aiKnownMove = AIKNOWNMOVE_UNPROBED;
+}
+
+/// @brief Stop the running AI job (if any), the search tree is kept
+static void aiStopJob(void)
+{
+    if(!aiJob)
+        return;
+    SDL_AtomicSet(&aiJob->cancel, 1);
+    aiFreeJob(aiJob);
+    aiJob = NULL;
+}
+
+void ai_Cancel(void)
+{
+    aiStopJob();
+    aiPonderStarted = false;
+    aiKnownMove = AIKNOWNMOVE_UNPROBED;
+    gamemcts_freeTree(aiTree);
+    aiTree = NULL;
+    aiPlayedMoveCount = 0;
+}
+
+void ai_MoveMade(int x, int y)
+{
+    if(aiPlayedMoveCount < AIMAXPLAYEDMOVES)
+        aiPlayedMoves[aiPlayedMoveCount] = (Vec2){x,y};
+    aiPlayedMoveCount = SDL_min(aiPlayedMoveCount+1, AIMAXPLAYEDMOVES+1);
+}
+
+void ai_Ponder(KRandom* random)
+{
+    bool mctsPlayer = false;
+    for(int i=0; i<4; i++)
+    {
+        if(aiPlayer[i] && aiDifficulty[i] == 5 && logicData->playerStatus[i] > PST_LOST)
+            mctsPlayer = true;
+    }
+    // Pondering is started once per turn, the job of the previous human player is stopped first
+    if(!aiPondering || !mctsPlayer || aiPonderStarted)
+        return;
+    aiPonderStarted = true;
+    aiStopJob();
+    aiStartJob(random, true);
+}
+
+void ai_TryMove(KRandom* random)
+{
+    // The human player has moved, the pondering results are picked up by the next search through the kept tree
+    if(aiJob && aiJob->pondering)
+        aiStopJob();
+    if(aiJob)
+    {
+        aiCheckJob();
+        return;
+    }
+    if(aiDifficulty[logicData->curPlayer] == 5 || ktimer_getTimeMillis(aiTimer) >= aiMoveDelay)
+        aiThinker(random);
+}
+
+struct AIContext* ai_createContext(int tableSize)
+{
+    struct AIContext* context = calloc(1,sizeof(struct AIContext));
+    if(!context)
+        return NULL;
+    if(tableSize > 0)
+    {
+        context->table = gametranstable_create((size_t)tableSize*1024*1024);
+        if(!context->table)
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"ai_createContext: Couldn't allocate a %d MB transposition table, searching without it instead!",tableSize);
+    }
+    return context;
+}
+
+void ai_freeContext(struct AIContext* context)
+{
+    if(!context)
+        return;
+    aiFreeFeatures(&context->features);
+    gamelogic_freeBoard(&context->board);
+    gametranstable_free(context->table);
+    free(context);
+}
+
+void ai_invalidateContext(struct AIContext* context)
+{
+    context->features.valid = false;
 }
 
-void ai_TryMove(void)
+bool ai_findMove(struct AIContext* context, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, int difficulty, KRandom* random, Vec2* move)
 {
-    if(ktimer_getTimeMillis(aiTimer) >= AIDELAY)
-        aiThinker();
+    // Only the tiles that changed since the previous call are recomputed in the feature index
+    struct AIFeatureIndex* featureIndex = &context->features;
+    if(context->board.owner && context->board.gridWidth == board->gridWidth && context->board.gridHeight == board->gridHeight)
+    {
+        if(featureIndex->valid && featureIndex->gridWidth == board->gridWidth && featureIndex->gridHeight == board->gridHeight)
+        {
+            int tileCount = board->gridWidth*board->gridHeight;
+            for(int i=0; i<tileCount; i++)
+            {
+                if(board->owner[i] != context->board.owner[i] || board->count[i] != context->board.count[i])
+                    aiMarkChangedTile(featureIndex, i % board->gridWidth, i / board->gridWidth);
+            }
+        }
+    }
+    else
+    {
+        // Table entries of another grid size can't be hit anymore (the grid size is a part of the position key)
+        gamelogic_freeBoard(&context->board);
+        if(!gamelogic_allocBoard(&context->board, board->gridWidth, board->gridHeight))
+            return false;
+        featureIndex->valid = false;
+        if(context->table)
+            gametranstable_clear(context->table);
+    }
+    gamelogic_copyBoard(&context->board, board);
+
+    if(difficulty >= 1 && difficulty <= 3)
+    {
+        struct AITiles* tiles = aiGetSpecialTiles(featureIndex, board, player, difficulty);
+        if(!tiles)
+            return false;
+        *move = aiPickTile(tiles, random);
+        return move->x >= 0;
+    }
+
+    bool found = false;
+    if(difficulty == 4)
+    {
+        int moveHintCount = 0;
+        Vec2* moveHints = aiGetSearchHints(featureIndex, board, player, random, &moveHintCount);
+        if(!moveHints)
+            return false;
+        struct AISearchParams params = aiSearchParams;
+        params.table = context->table;
+        struct AISearchResult result;
+        found = gamesearch_findMove(board, player, playerStatus, moveHints, moveHintCount, &params, &result);
+        free(moveHints);
+        if(found)
+            *move = result.move;
+    }
+    else if(difficulty == 5)
+    {
+        struct AIMCTSResult result;
+        found = gamemcts_findMove(board, player, playerStatus, &aiMCTSParams, random, &result);
+        if(found)
+            *move = result.move;
+    }
+    return found;
 }
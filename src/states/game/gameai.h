@@ -1,17 +1,102 @@
 #pragma once
 #include <stdbool.h>
+#include "../../utils/random.h"
+#include "gamesearch.h"
+#include "gamemcts.h"
+#include "gamebook.h"
+#include "gametablebase.h"
 
 // Array of whether a player is AI (true) or not (false)
 extern bool aiPlayer[4];
 
-// Array of AI player difficulties (1-3, only if player is AI)
+// Array of AI player difficulties (1-5, only if player is AI), 4 is the alpha-beta search AI, 5 is the Monte Carlo tree search AI
 extern int aiDifficulty[4];
 
-// Initializes AI values
+// Search depth and time budget of the difficulty 4 AI
+extern struct AISearchParams aiSearchParams;
+
+// Time budget and exploration constant of the difficulty 5 AI
+extern struct AIMCTSParams aiMCTSParams;
+
+// Should the difficulty 5 AI keep searching during human player turns
+extern bool aiPondering;
+
+// Amount of threads used by the difficulty 4 and 5 AI searches (0 = one per CPU core), has to be set before the first game
+extern int aiThreadCount;
+
+// Time an AI player waits before making its move in milliseconds (the difficulty 5 AI searches during it)
+extern int aiMoveDelay;
+
+// Should the difficulty 4 and 5 AI search on a worker thread, headless programs that don't have to keep rendering search on the calling thread instead
+extern bool aiWorkerThread;
+
+// Transposition table size of the difficulty 4 AI in megabytes (0 = no table), has to be set before the first game
+extern int aiTableSize;
+
+// Opening book used by the difficulty 4 and 5 AI instead of searching (NULL = no book)
+extern struct OpeningBook* aiBook;
+
+// Solved small grid positions the difficulty 4 and 5 AI play the winning move of instead of searching (NULL = no tablebase)
+extern struct Tablebase* aiTablebase;
+
+// Position evaluation weights of the difficulty 4 AI, the built-in default weights unless game_init loads a weights file
+extern struct EvalWeights aiEvalWeights;
+
+// Initializes AI values, called once the players of a new or loaded game are known
 void ai_Init(void);
 
-// Resets AI delay time
+// Stops the AI and frees everything ai_Init allocated, called when the game quits
+void ai_Quit(void);
+
+/// @brief Marks the features of a tile and the tiles depending on it for recomputing, called for every tile a move or explosion changes
+/// @param x Tile X position
+/// @param y Tile Y position
+void ai_TileChanged(int x, int y);
+
+// Resets AI delay time and the tablebase/book move of the turn, called at the start of every turn
 void ai_ResetTime(void);
 
-// Tries to make the AI move, succeeds if the AI delay has passed
-void ai_TryMove(void);
+/// @brief Stops the AI search running on the worker thread (if any) and throws its result and the kept search tree away
+void ai_Cancel(void);
+
+/// @brief Remembers a move made by any player, so the kept search tree of the difficulty 5 AI can follow it
+/// @param x Tile X position
+/// @param y Tile Y position
+void ai_MoveMade(int x, int y);
+
+/// @brief Starts or continues the difficulty 5 AI search during a human player turn, the results are reused by the next AI move through the kept search tree
+/// @param random Random number generator the pondering generator is seeded from
+void ai_Ponder(KRandom* random);
+
+/// @brief Tries to make the AI move, succeeds if the AI delay has passed (the difficulty 5 AI spends the delay searching instead of waiting).
+/// The difficulty 4 and 5 AI search on a worker thread, later calls make the move once the search is done.
+/// @param random Random number generator used to pick between equally good moves
+void ai_TryMove(KRandom* random);
+
+// AI state of games played without the game state, every thread playing games needs its own context
+struct AIContext;
+
+/// @brief Create an AI context for ai_findMove
+/// @param tableSize Transposition table size of the difficulty 4 AI in megabytes (0 = no table)
+/// @return AI context or NULL on allocation failure
+struct AIContext* ai_createContext(int tableSize);
+
+/// @brief Free an AI context created by ai_createContext
+/// @param context AI context (can be NULL)
+void ai_freeContext(struct AIContext* context);
+
+/// @brief Make the next ai_findMove call of a context recompute the tile features of the whole board like for a new game, the allocations are kept
+/// @param context AI context
+void ai_invalidateContext(struct AIContext* context);
+
+/// @brief Find the move of an AI player on a board without the game state, the search settings are taken from aiSearchParams and aiMCTSParams.
+/// The searches run on the calling thread without the opening book and the tablebase, so several threads can find moves at the same time with their own contexts.
+/// @param context AI context of the calling thread
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @param player Player to move
+/// @param difficulty AI difficulty (1-5)
+/// @param random Random number generator used to pick between equally good moves and by the difficulty 5 AI playouts
+/// @param move Move to write
+/// @return true on success, false if the difficulty is invalid, there are no moves or the allocation failed
+bool ai_findMove(struct AIContext* context, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, int difficulty, KRandom* random, Vec2* move);
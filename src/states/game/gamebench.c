@@ -0,0 +1,109 @@
+#include "gamebench.h"
+#include "gamesearch.h"
+#include "gamemcts.h"
+#include "../../utils/random.h"
+#include "../../utils/timer.h"
+#include "../../utils/threadpool.h"
+#include <SDL2/SDL.h>
+#include <string.h>
+
+// Amount of benchmark positions
+#define BENCH_POSITIONS 4
+
+// Search depth of the difficulty 4 AI benchmark
+#define BENCH_SEARCHDEPTH 5
+
+// Playouts per position of the difficulty 5 AI benchmark
+#define BENCH_PLAYOUTS 20000
+
+bool gamebench_makePosition(struct BenchPosition* position, int playerCount, int moveCount, uint64_t seed)
+{
+    if(!gamelogic_allocBoard(&position->board, BENCH_GRIDWIDTH, BENCH_GRIDHEIGHT))
+        return false;
+    for(int p=0; p<4; p++)
+        position->playerStatus[p] = (p < playerCount) ? PST_NOTSTARTED : PST_NOTPRESENT;
+    position->player = 0;
+
+    KRandom random;
+    krandom_seed(&random, seed);
+    for(int i=0; i<moveCount; i++)
+    {
+        int x, y;
+        do {
+            x = krandom_range(&random, BENCH_GRIDWIDTH);
+            y = krandom_range(&random, BENCH_GRIDHEIGHT);
+        } while(gamelogic_resolveMove(&position->board, position->playerStatus, x, y, position->player) == -1);
+        // Stop before the game ends, so every position has something to search
+        if(gamelogic_updatePlayerStatus(&position->board, position->playerStatus, position->player))
+            break;
+        position->player = gamelogic_getNextPlayer(position->playerStatus, position->player);
+    }
+    return true;
+}
+
+void gamebench_runAI(int maxThreads)
+{
+    if(maxThreads <= 0)
+        maxThreads = SDL_GetCPUCount();
+    maxThreads = SDL_clamp(maxThreads, 1, KTHREADPOOL_MAX_THREADS);
+
+    struct BenchPosition positions[BENCH_POSITIONS];
+    int positionCount = 0;
+    for(; positionCount<BENCH_POSITIONS; positionCount++)
+    {
+        // Even positions have 2 players, odd ones 4, later positions are deeper in the game
+        int playerCount = (positionCount % 2 == 0) ? 2 : 4;
+        if(!gamebench_makePosition(&positions[positionCount], playerCount, 8 + positionCount*8, positionCount+1))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gamebench_runAI: Couldn't allocate the benchmark positions!");
+            break;
+        }
+    }
+
+    KTimer* timer = ktimer_create();
+    float searchTimes[KTHREADPOOL_MAX_THREADS];
+    float mctsTimes[KTHREADPOOL_MAX_THREADS];
+    SDL_Log("AI benchmark: %d positions, AI 4 depth %d, AI 5 %d playouts per position, %d CPU cores",positionCount,BENCH_SEARCHDEPTH,BENCH_PLAYOUTS,SDL_GetCPUCount());
+    for(int threads=1; threads<=maxThreads && timer && positionCount == BENCH_POSITIONS; threads++)
+    {
+        KThreadPool* pool = (threads > 1) ? kthreadpool_create(threads) : NULL;
+        if(threads > 1 && !pool)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gamebench_runAI: Couldn't create a thread pool with %d threads!",threads);
+            break;
+        }
+
+        // The alpha-beta search does more work with more threads, so its node count is logged as well
+        struct AISearchParams searchParams = {BENCH_SEARCHDEPTH, 0, NULL, pool};
+        long nodes = 0;
+        ktimer_setTimeMillis(timer, 0);
+        for(int i=0; i<positionCount; i++)
+        {
+            struct AISearchResult result;
+            if(gamesearch_findMove(&positions[i].board, positions[i].player, positions[i].playerStatus, NULL, 0, &searchParams, &result))
+                nodes += result.nodes;
+        }
+        searchTimes[threads-1] = ktimer_getTimeFloat(timer);
+
+        struct AIMCTSParams mctsParams = {0, BENCH_PLAYOUTS, 0.7f, NULL, pool};
+        long playouts = 0;
+        KRandom random;
+        krandom_seed(&random, 1);
+        ktimer_setTimeMillis(timer, 0);
+        for(int i=0; i<positionCount; i++)
+        {
+            struct AIMCTSResult result;
+            if(gamemcts_findMove(&positions[i].board, positions[i].player, positions[i].playerStatus, &mctsParams, &random, &result))
+                playouts += result.playouts;
+        }
+        mctsTimes[threads-1] = ktimer_getTimeFloat(timer);
+        kthreadpool_destroy(pool);
+
+        SDL_Log("%2d threads: AI 4 %7.1f ms, %8ld positions, speedup %.2fx | AI 5 %7.1f ms, %7.0f playouts/s, speedup %.2fx",threads,
+            searchTimes[threads-1]*1000.0f,nodes,searchTimes[0]/SDL_max(searchTimes[threads-1],0.0001f),
+            mctsTimes[threads-1]*1000.0f,playouts/SDL_max(mctsTimes[threads-1],0.0001f),mctsTimes[0]/SDL_max(mctsTimes[threads-1],0.0001f));
+    }
+    ktimer_destroy(timer);
+    for(int i=0; i<positionCount; i++)
+        gamelogic_freeBoard(&positions[i].board);
+}
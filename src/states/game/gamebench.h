@@ -0,0 +1,29 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gamelogic.h"
+
+// Grid size of the benchmark positions (the default game grid size)
+#define BENCH_GRIDWIDTH 10
+#define BENCH_GRIDHEIGHT 6
+
+// Benchmark position
+struct BenchPosition {
+    struct KABoard board;
+    enum PlayerStatus playerStatus[4];
+    int player;                         //Player to move
+};
+
+/// @brief Build a BENCH_GRIDWIDTH x BENCH_GRIDHEIGHT position by playing random legal moves, the same arguments always give the same position.
+/// Stops before the game ends, so every position has a player to move. Free the board with gamelogic_freeBoard.
+/// @param position Position to write to
+/// @param playerCount Amount of players (2-4)
+/// @param moveCount Amount of moves to play (less if the next move would end the game)
+/// @param seed Random seed
+/// @return true on success, false on allocation failure
+bool gamebench_makePosition(struct BenchPosition* position, int playerCount, int moveCount, uint64_t seed);
+
+/// @brief Measure the difficulty 4 and 5 AI search speed on fixed positions with 1 to maxThreads threads and log the speedup of every thread count.
+/// The searches use fixed depth and playout budgets, so every thread count does comparable work.
+/// @param maxThreads Max amount of threads (0 = one per CPU core)
+void gamebench_runAI(int maxThreads);
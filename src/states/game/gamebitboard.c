@@ -0,0 +1,311 @@
+#include "gamebitboard.h"
+#include <SDL2/SDL.h>
+#include <string.h>
+
+static KAMask maskAnd(KAMask a, KAMask b)
+{
+    return (KAMask){a.lo & b.lo, a.hi & b.hi};
+}
+
+static KAMask maskOr(KAMask a, KAMask b)
+{
+    return (KAMask){a.lo | b.lo, a.hi | b.hi};
+}
+
+static KAMask maskXor(KAMask a, KAMask b)
+{
+    return (KAMask){a.lo ^ b.lo, a.hi ^ b.hi};
+}
+
+// Returns tiles present in a, but not in b
+static KAMask maskAndNot(KAMask a, KAMask b)
+{
+    return (KAMask){a.lo & ~b.lo, a.hi & ~b.hi};
+}
+
+static bool maskIsEmpty(KAMask a)
+{
+    return (a.lo | a.hi) == 0;
+}
+
+static int maskPopCount(KAMask a)
+{
+    return __builtin_popcountll(a.lo) + __builtin_popcountll(a.hi);
+}
+
+static bool maskTestBit(KAMask a, int bit)
+{
+    return (bit < 64) ? ((a.lo >> bit) & 1) : ((a.hi >> (bit-64)) & 1);
+}
+
+static void maskSetBit(KAMask* a, int bit)
+{
+    if(bit < 64)
+        a->lo |= (uint64_t)1 << bit;
+    else
+        a->hi |= (uint64_t)1 << (bit-64);
+}
+
+static void maskClearBit(KAMask* a, int bit)
+{
+    if(bit < 64)
+        a->lo &= ~((uint64_t)1 << bit);
+    else
+        a->hi &= ~((uint64_t)1 << (bit-64));
+}
+
+// Moves every tile n bits up (to higher tile indices)
+static KAMask maskShiftUp(KAMask a, int n)
+{
+    if(n == 0)
+        return a;
+    if(n >= 64)
+        return (KAMask){0, a.lo << (n-64)};
+    return (KAMask){a.lo << n, (a.hi << n) | (a.lo >> (64-n))};
+}
+
+// Moves every tile n bits down (to lower tile indices)
+static KAMask maskShiftDown(KAMask a, int n)
+{
+    if(n == 0)
+        return a;
+    if(n >= 64)
+        return (KAMask){a.hi >> (n-64), 0};
+    return (KAMask){(a.lo >> n) | (a.hi << (64-n)), a.hi >> n};
+}
+
+/// @brief Add 1 atom to every tile in a mask (bit-sliced ripple carry)
+/// @param bitboard Bitboard
+/// @param tiles Tiles to add an atom to
+/// @return true on success, false if any tile overflowed
+static bool addAtomMask(struct KABitboard* bitboard, KAMask tiles)
+{
+    KAMask carry = tiles;
+    for(int i=0; i<BITBOARD_COUNT_PLANES && !maskIsEmpty(carry); i++)
+    {
+        KAMask newCarry = maskAnd(bitboard->count[i], carry);
+        bitboard->count[i] = maskXor(bitboard->count[i], carry);
+        carry = newCarry;
+    }
+    return maskIsEmpty(carry);
+}
+
+// Get the atom count of a single tile
+static int getTileCount(const struct KABitboard* bitboard, int bit)
+{
+    int count = 0;
+    for(int i=0; i<BITBOARD_COUNT_PLANES; i++)
+        count |= maskTestBit(bitboard->count[i], bit) << i;
+    return count;
+}
+
+/// @brief Set the atom count of a single tile
+/// @param bitboard Bitboard
+/// @param bit Tile index
+/// @param count New atom count
+/// @return true on success, false if count doesn't fit in the count planes
+static bool setTileCount(struct KABitboard* bitboard, int bit, int count)
+{
+    if(count >= (1 << BITBOARD_COUNT_PLANES))
+        return false;
+    for(int i=0; i<BITBOARD_COUNT_PLANES; i++)
+    {
+        if((count >> i) & 1)
+            maskSetBit(&bitboard->count[i], bit);
+        else
+            maskClearBit(&bitboard->count[i], bit);
+    }
+    return true;
+}
+
+bool gamebitboard_initMasks(struct KABitboardMasks* masks, int gridWidth, int gridHeight)
+{
+    memset(masks, 0, sizeof(struct KABitboardMasks));
+    if(gridWidth <= 0 || gridHeight <= 0 || gridWidth*gridHeight > BITBOARD_MAX_TILES)
+        return false;
+
+    masks->gridWidth = gridWidth;
+    masks->gridHeight = gridHeight;
+    for(int y=0; y<gridHeight; y++)
+    {
+        for(int x=0; x<gridWidth; x++)
+        {
+            int bit = y*gridWidth+x;
+            // Same critical amounts as GameLogicData.critGrid
+            int crit = 4 - (x == 0 || x == gridWidth-1) - (y == 0 || y == gridHeight-1);
+            maskSetBit(&masks->all, bit);
+            maskSetBit(&masks->crit[crit-2], bit);
+            if(x > 0)
+                maskSetBit(&masks->notFirstColumn, bit);
+            if(x < gridWidth-1)
+                maskSetBit(&masks->notLastColumn, bit);
+        }
+    }
+    return true;
+}
+
+bool gamebitboard_fromBoard(struct KABitboard* bitboard, const struct KABoard* board, const struct KABitboardMasks* masks)
+{
+    memset(bitboard, 0, sizeof(struct KABitboard));
+    bitboard->masks = masks;
+    if(board->gridWidth != masks->gridWidth || board->gridHeight != masks->gridHeight)
+        return false;
+
+    int tileCount = board->gridWidth*board->gridHeight;
+    for(int i=0; i<tileCount; i++)
+    {
+        if(board->owner[i] == NOOWNER)
+            continue;
+        if(!setTileCount(bitboard, i, board->count[i]))
+            return false;
+        maskSetBit(&bitboard->owner[board->owner[i]], i);
+    }
+    return true;
+}
+
+void gamebitboard_toBoard(const struct KABitboard* bitboard, struct KABoard* board)
+{
+    board->gridWidth = bitboard->masks->gridWidth;
+    board->gridHeight = bitboard->masks->gridHeight;
+    memset(board->playerAtoms, 0, sizeof(board->playerAtoms));
+    int tileCount = board->gridWidth*board->gridHeight;
+    for(int i=0; i<tileCount; i++)
+    {
+        int oldOwner = board->owner[i];
+        int oldCount = board->count[i];
+        board->owner[i] = NOOWNER;
+        board->count[i] = 0;
+        for(int p=0; p<4; p++)
+        {
+            if(maskTestBit(bitboard->owner[p], i))
+            {
+                board->owner[i] = p;
+                board->count[i] = getTileCount(bitboard, i);
+                board->playerAtoms[p] += board->count[i];
+                break;
+            }
+        }
+        // Only tiles changed by the bitboard update the Zobrist key
+        if(board->owner[i] != oldOwner || (int)board->count[i] != oldCount)
+            board->hash ^= gamelogic_getTileKey(i, oldOwner, oldCount) ^ gamelogic_getTileKey(i, board->owner[i], board->count[i]);
+    }
+}
+
+KAMask gamebitboard_getCritical(const struct KABitboard* bitboard)
+{
+    const KAMask* count = bitboard->count;
+    const KAMask* crit = bitboard->masks->crit;
+    KAMask atLeast2 = maskOr(count[1], maskOr(count[2], count[3]));
+    KAMask atLeast3 = maskOr(maskAnd(count[0], count[1]), maskOr(count[2], count[3]));
+    KAMask atLeast4 = maskOr(count[2], count[3]);
+    return maskOr(maskAnd(crit[0], atLeast2), maskOr(maskAnd(crit[1], atLeast3), maskAnd(crit[2], atLeast4)));
+}
+
+int gamebitboard_explodeWave(struct KABitboard* bitboard, int player)
+{
+    const struct KABitboardMasks* masks = bitboard->masks;
+    int gridWidth = masks->gridWidth;
+    KAMask critical = gamebitboard_getCritical(bitboard);
+    if(maskIsEmpty(critical))
+        return 0;
+
+    // Tiles with more atoms than their critical amount give the extra atoms to the first nearby tile (down, up, right, left)
+    const KAMask* count = bitboard->count;
+    KAMask atLeast3 = maskOr(maskAnd(count[0], count[1]), maskOr(count[2], count[3]));
+    KAMask atLeast4 = maskOr(count[2], count[3]);
+    KAMask atLeast5 = maskOr(count[3], maskAnd(count[2], maskOr(count[0], count[1])));
+    KAMask overCrit = maskOr(maskAnd(masks->crit[0], atLeast3), maskOr(maskAnd(masks->crit[1], atLeast4), maskAnd(masks->crit[2], atLeast5)));
+    int extraTiles[BITBOARD_MAX_TILES];
+    int extraCounts[BITBOARD_MAX_TILES];
+    int extraCount = 0;
+    while(!maskIsEmpty(overCrit))
+    {
+        int bit = (overCrit.lo != 0) ? __builtin_ctzll(overCrit.lo) : (64 + __builtin_ctzll(overCrit.hi));
+        maskClearBit(&overCrit, bit);
+        int x = bit % gridWidth;
+        int y = bit / gridWidth;
+        int crit = 4 - (x == 0 || x == gridWidth-1) - (y == 0 || y == masks->gridHeight-1);
+        if(y < masks->gridHeight-1)
+            extraTiles[extraCount] = bit+gridWidth;
+        else if(y > 0)
+            extraTiles[extraCount] = bit-gridWidth;
+        else if(x < gridWidth-1)
+            extraTiles[extraCount] = bit+1;
+        else
+            extraTiles[extraCount] = bit-1;
+        extraCounts[extraCount++] = getTileCount(bitboard, bit) - crit;
+    }
+
+    // Remove the atoms from exploding tiles
+    for(int i=0; i<BITBOARD_COUNT_PLANES; i++)
+        bitboard->count[i] = maskAndNot(bitboard->count[i], critical);
+    for(int p=0; p<4; p++)
+        bitboard->owner[p] = maskAndNot(bitboard->owner[p], critical);
+
+    // Spread 1 atom in every direction
+    KAMask spread[4] = {
+        maskAnd(maskShiftUp(critical, gridWidth), masks->all),
+        maskShiftDown(critical, gridWidth),
+        maskAnd(maskShiftUp(critical, 1), masks->notFirstColumn),
+        maskAnd(maskShiftDown(critical, 1), masks->notLastColumn)
+    };
+    KAMask received = {0,0};
+    for(int i=0; i<4; i++)
+    {
+        if(!addAtomMask(bitboard, spread[i]))
+            return -1;
+        received = maskOr(received, spread[i]);
+    }
+    for(int i=0; i<extraCount; i++)
+    {
+        if(!setTileCount(bitboard, extraTiles[i], getTileCount(bitboard, extraTiles[i]) + extraCounts[i]))
+            return -1;
+    }
+
+    // Every tile that got atoms now belongs to the player
+    for(int p=0; p<4; p++)
+        bitboard->owner[p] = maskAndNot(bitboard->owner[p], received);
+    bitboard->owner[player] = maskOr(bitboard->owner[player], received);
+    return maskPopCount(critical);
+}
+
+int gamebitboard_resolveMove(struct KABitboard* bitboard, int x, int y, int player, bool canWin)
+{
+    const struct KABitboardMasks* masks = bitboard->masks;
+    if(x < 0 || x >= masks->gridWidth || y < 0 || y >= masks->gridHeight || player < 0 || player > 3)
+        return -1;
+    int bit = y*masks->gridWidth+x;
+    for(int p=0; p<4; p++)
+    {
+        if(p != player && maskTestBit(bitboard->owner[p], bit))
+            return -1;
+    }
+
+    if(!setTileCount(bitboard, bit, getTileCount(bitboard, bit) + 1))
+        return -1;
+    maskSetBit(&bitboard->owner[player], bit);
+
+    int explosionCount = 0;
+    while(true)
+    {
+        int waveExplosions = gamebitboard_explodeWave(bitboard, player);
+        if(waveExplosions < 0)
+            return -1;
+        if(waveExplosions == 0)
+            break;
+        explosionCount += waveExplosions;
+        if(!canWin)
+            continue;
+
+        // Every atom belongs to the player, so the chain reaction can't change the result anymore
+        KAMask enemyTiles = {0,0};
+        for(int p=0; p<4; p++)
+        {
+            if(p != player)
+                enemyTiles = maskOr(enemyTiles, bitboard->owner[p]);
+        }
+        if(maskIsEmpty(enemyTiles))
+            break;
+    }
+    return explosionCount;
+}
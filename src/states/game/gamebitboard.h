@@ -0,0 +1,72 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gamelogic.h"
+
+// Max tile count supported by the bitboard (every tile is 1 bit of a 128-bit mask)
+#define BITBOARD_MAX_TILES 128
+
+// Amount of bit-sliced atom count planes (tiles can hold up to 2^BITBOARD_COUNT_PLANES-1 atoms)
+#define BITBOARD_COUNT_PLANES 4
+
+// 128-bit tile mask, bit number is equal to the KABoard tile index (y*gridWidth+x)
+typedef struct KAMask {
+    uint64_t lo;    //Tiles 0-63
+    uint64_t hi;    //Tiles 64-127
+} KAMask;
+
+// Masks precomputed for a given grid size
+struct KABitboardMasks {
+    int gridWidth;          //Grid width in tiles
+    int gridHeight;         //Grid height in tiles
+    KAMask all;             //Every tile on the grid
+    KAMask crit[3];         //Tiles with critical amount of 2 (corners), 3 (sides) and 4 (interior)
+    KAMask notFirstColumn;  //Every tile except the ones with X = 0
+    KAMask notLastColumn;   //Every tile except the ones with X = gridWidth-1
+};
+
+// Bitboard version of KABoard
+struct KABitboard {
+    const struct KABitboardMasks* masks;    //Masks for the bitboard grid size
+    KAMask owner[4];                        //Tiles owned by each player
+    KAMask count[BITBOARD_COUNT_PLANES];    //Bit-sliced atom counts (plane N holds bit N of every tile atom count)
+};
+
+/// @brief Precompute the masks for a given grid size
+/// @param masks Mask struct to fill
+/// @param gridWidth Grid width
+/// @param gridHeight Grid height
+/// @return true on success, false if the grid has more than BITBOARD_MAX_TILES tiles
+bool gamebitboard_initMasks(struct KABitboardMasks* masks, int gridWidth, int gridHeight);
+
+/// @brief Convert a compact board to a bitboard
+/// @param bitboard Bitboard to write to
+/// @param board Source board
+/// @param masks Masks precomputed for the board grid size
+/// @return true on success, false if the board doesn't fit in a bitboard (too many tiles or atoms on a tile)
+bool gamebitboard_fromBoard(struct KABitboard* bitboard, const struct KABoard* board, const struct KABitboardMasks* masks);
+
+/// @brief Convert a bitboard back to a compact board
+/// @param bitboard Source bitboard
+/// @param board Board to write to, its Zobrist key is updated for the tiles that changed
+void gamebitboard_toBoard(const struct KABitboard* bitboard, struct KABoard* board);
+
+/// @brief Get every critical tile (with at least its critical amount of atoms)
+/// @param bitboard Bitboard
+/// @return Mask of critical tiles
+KAMask gamebitboard_getCritical(const struct KABitboard* bitboard);
+
+/// @brief Explode every critical tile at once. All the atoms given to nearby tiles go to the player.
+/// @param bitboard Bitboard
+/// @param player Player the explosions belong to
+/// @return Amount of explosions or -1 if a tile would get more atoms than the bitboard can store
+int gamebitboard_explodeWave(struct KABitboard* bitboard, int player);
+
+/// @brief Place an atom and resolve the chain reaction wave by wave
+/// @param bitboard Bitboard
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @param player Player making the move
+/// @param canWin true if the chain reaction stops once every atom belongs to the player (no other player is PST_NOTSTARTED)
+/// @return Amount of explosions, -1 if the move is invalid or the atom count overflowed (bitboard contents are undefined in that case)
+int gamebitboard_resolveMove(struct KABitboard* bitboard, int x, int y, int player, bool canWin);
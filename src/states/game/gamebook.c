@@ -0,0 +1,156 @@
+#include "gamebook.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the book file header (magic number, version and entry count)
+#define BOOK_HEADER_SIZE 10
+
+// Size of a book file entry (position key and move)
+#define BOOK_ENTRY_SIZE 10
+
+struct OpeningBook {
+    struct KASymmetry symmetry; //Symmetry data of the last probed grid size
+    int entryCount;
+    uint64_t* keys;     //Position keys in ascending order
+    uint16_t* moves;    //Tile index of the book move of every key
+};
+
+/// @brief Mix a value into a 64-bit key (splitmix64 finalizer)
+/// @param value Value to mix
+/// @return Mixed key
+static uint64_t bookMix(uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+struct OpeningBook* gamebook_load(const void* data, size_t size)
+{
+    SDL_RWops* stream = SDL_RWFromConstMem(data, (int)size);
+    if(!stream)
+        return NULL;
+    char magic[4];
+    if(size < BOOK_HEADER_SIZE || SDL_RWread(stream, magic, 1, 4) != 4 || memcmp(magic, BOOK_MAGIC, 4) != 0 || SDL_ReadLE16(stream) != BOOK_VERSION)
+    {
+        SDL_RWclose(stream);
+        return NULL;
+    }
+    uint32_t entryCount = SDL_ReadLE32(stream);
+    if(entryCount > (size-BOOK_HEADER_SIZE)/BOOK_ENTRY_SIZE)
+    {
+        SDL_RWclose(stream);
+        return NULL;
+    }
+
+    struct OpeningBook* book = calloc(1,sizeof(struct OpeningBook));
+    if(book)
+    {
+        book->keys = malloc(SDL_max(entryCount,1)*sizeof(uint64_t));
+        book->moves = malloc(SDL_max(entryCount,1)*sizeof(uint16_t));
+    }
+    if(!book || !book->keys || !book->moves)
+    {
+        gamebook_free(book);
+        SDL_RWclose(stream);
+        return NULL;
+    }
+    book->entryCount = entryCount;
+    for(uint32_t i=0; i<entryCount; i++)
+    {
+        book->keys[i] = SDL_ReadLE64(stream);
+        book->moves[i] = SDL_ReadLE16(stream);
+        // Binary search needs the keys in ascending order
+        if(i > 0 && book->keys[i] <= book->keys[i-1])
+        {
+            gamebook_free(book);
+            SDL_RWclose(stream);
+            return NULL;
+        }
+    }
+    SDL_RWclose(stream);
+    return book;
+}
+
+void gamebook_free(struct OpeningBook* book)
+{
+    if(!book)
+        return;
+    gamesymmetry_free(&book->symmetry);
+    free(book->keys);
+    free(book->moves);
+    free(book);
+}
+
+bool gamebook_getKey(const struct KASymmetry* sym, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, uint64_t* key, int* transform)
+{
+    int opponent = NOPLAYER;
+    for(int p=0; p<4; p++)
+    {
+        // A player who lost has no atoms left, so the game plays like a 2 player game from then on
+        if(p == player || playerStatus[p] <= PST_LOST)
+            continue;
+        if(opponent != NOPLAYER)
+            return false;
+        opponent = p;
+    }
+    if(opponent == NOPLAYER || playerStatus[player] <= PST_LOST)
+        return false;
+
+    // Tiles of the player to move use owner 0, tiles of the opponent use owner 1
+    int ownerMap[4];
+    for(int p=0; p<4; p++)
+        ownerMap[p] = (p == player) ? 0 : 1;
+    uint64_t positionKey;
+    *transform = gamesymmetry_canonicalize(sym, board, ownerMap, &positionKey);
+    positionKey ^= bookMix(((uint64_t)board->explosionMode << 32) | ((uint64_t)board->gridHeight << 16) | board->gridWidth);
+    if(playerStatus[player] == PST_NOTSTARTED)
+        positionKey ^= bookMix(1ULL << 48);
+    if(playerStatus[opponent] == PST_NOTSTARTED)
+        positionKey ^= bookMix(2ULL << 48);
+    *key = positionKey;
+    return true;
+}
+
+int gamebook_probe(struct OpeningBook* book, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player)
+{
+    if(!book)
+        return -1;
+    if(book->symmetry.gridWidth != board->gridWidth || book->symmetry.gridHeight != board->gridHeight)
+    {
+        gamesymmetry_free(&book->symmetry);
+        if(!gamesymmetry_init(&book->symmetry, board->gridWidth, board->gridHeight))
+            return -1;
+    }
+    uint64_t key;
+    int transform;
+    if(!gamebook_getKey(&book->symmetry, board, playerStatus, player, &key, &transform))
+        return -1;
+    int low = 0;
+    int high = book->entryCount-1;
+    while(low <= high)
+    {
+        int mid = low + (high-low)/2;
+        if(book->keys[mid] < key)
+        {
+            low = mid+1;
+        }
+        else if(book->keys[mid] > key)
+        {
+            high = mid-1;
+        }
+        else
+        {
+            // A key collision could give a move that isn't legal in this position
+            if(book->moves[mid] >= board->gridWidth*board->gridHeight)
+                return -1;
+            int move = gamesymmetry_untransformMove(&book->symmetry, transform, book->moves[mid]);
+            if(board->owner[move] != NOOWNER && board->owner[move] != player)
+                return -1;
+            return move;
+        }
+    }
+    return -1;
+}
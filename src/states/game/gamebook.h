@@ -0,0 +1,46 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "gamelogic.h"
+#include "gamesymmetry.h"
+
+// Opening book file magic number
+#define BOOK_MAGIC "KAOB"
+
+// Opening book file format version, has to be raised when the file layout or the position keys change
+#define BOOK_VERSION 2
+
+// Sorted table of opening positions of 2 player games and the moves found for them by deep offline searches.
+// Positions are stored in their canonical orientation (see gamesymmetry_canonicalize), so mirrored and rotated openings share an entry.
+// The file starts with BOOK_MAGIC, the version (LE16) and the entry count (LE32), followed by the entries sorted by key:
+// position key (LE64, see gamebook_getKey) and move tile index in the canonical orientation (LE16).
+struct OpeningBook;
+
+/// @brief Load an opening book from memory
+/// @param data Book file data
+/// @param size Book file size in bytes
+/// @return Opening book or NULL if the data is invalid or couldn't be allocated
+struct OpeningBook* gamebook_load(const void* data, size_t size);
+
+/// @brief Free an opening book
+/// @param book Opening book (can be NULL)
+void gamebook_free(struct OpeningBook* book);
+
+/// @brief Get the book key of a position in its canonical orientation, players are numbered from the player to move, so the key doesn't depend on the player slots used
+/// @param sym Symmetry data of the board size
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @param player Player to move
+/// @param key Key to write to
+/// @param transform Transform to the canonical orientation to write to
+/// @return true if the position can be in a book (exactly 2 players left in the game), false otherwise
+bool gamebook_getKey(const struct KASymmetry* sym, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, uint64_t* key, int* transform);
+
+/// @brief Look the book move of a position up
+/// @param book Opening book (can be NULL), keeps the symmetry data of the last probed grid size
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @param player Player to move
+/// @return Tile index of the book move or -1 if the position isn't in the book
+int gamebook_probe(struct OpeningBook* book, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player);
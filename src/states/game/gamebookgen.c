@@ -0,0 +1,187 @@
+#include "gamebookgen.h"
+#include "gamebook.h"
+#include "gamesearch.h"
+#include "../../game/game.h"
+#include "../../utils/threadpool.h"
+#include "../../utils/timer.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Transposition table size of the book searches in megabytes
+#define BOOK_TABLESIZE 64
+
+// Book entry collected by the generator
+struct BookEntry {
+    uint64_t key;
+    uint16_t move;
+};
+
+// Opening book generator state
+struct BookGenerator {
+    struct BookEntry* entries;
+    int entryCount;
+    int entryCapacity;
+    int gridStart;                  //First entry of the current grid size and explosion mode (positions of other grids never match)
+    struct KASymmetry symmetry;     //Symmetry data of the current grid size
+    int plies;                      //Amount of plies covered by the book
+    struct AISearchParams params;   //Budget of every search
+};
+
+/// @brief Add an entry to the generated book
+/// @param gen Book generator
+/// @param key Position key
+/// @param move Tile index of the book move
+/// @return true on success, false on allocation failure
+static bool bookAddEntry(struct BookGenerator* gen, uint64_t key, int move)
+{
+    if(gen->entryCount >= gen->entryCapacity)
+    {
+        int newCapacity = SDL_max(gen->entryCapacity*2, 256);
+        struct BookEntry* newEntries = realloc(gen->entries, newCapacity*sizeof(struct BookEntry));
+        if(!newEntries)
+            return false;
+        gen->entries = newEntries;
+        gen->entryCapacity = newCapacity;
+    }
+    gen->entries[gen->entryCount++] = (struct BookEntry){key, move};
+    return true;
+}
+
+/// @brief Search the book move of a position and expand every legal move of the player to move, the positions are searched depth-first
+/// @param gen Book generator
+/// @param board Position board
+/// @param playerStatus Position player statuses
+/// @param player Player to move
+/// @param ply Amount of plies played from the empty board
+/// @return true on success, false on allocation failure
+static bool bookExpand(struct BookGenerator* gen, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, int ply)
+{
+    uint64_t key;
+    int transform;
+    if(!gamebook_getKey(&gen->symmetry, board, playerStatus, player, &key, &transform))
+        return true;
+    // Positions reached by different move orders or mirrored moves are searched once
+    for(int i=gen->gridStart; i<gen->entryCount; i++)
+    {
+        if(gen->entries[i].key == key)
+            return true;
+    }
+    struct AISearchResult result;
+    if(!gamesearch_findMove(board, player, playerStatus, NULL, 0, &gen->params, &result))
+        return true;
+    if(!bookAddEntry(gen, key, gamesymmetry_transformMove(&gen->symmetry, transform, BOARD_INDEX(board,result.move.x,result.move.y))))
+        return false;
+    if(ply+1 >= gen->plies)
+        return true;
+
+    // The opponent can be a human player, so every reply is added to the book
+    struct KABoard child;
+    if(!gamelogic_allocBoard(&child, board->gridWidth, board->gridHeight))
+        return false;
+    bool success = true;
+    for(int i=0; i<board->gridWidth*board->gridHeight && success; i++)
+    {
+        if(board->owner[i] != NOOWNER && board->owner[i] != player)
+            continue;
+        enum PlayerStatus childStatus[4];
+        memcpy(childStatus, playerStatus, sizeof(childStatus));
+        gamelogic_copyBoard(&child, board);
+        gamelogic_resolveMove(&child, childStatus, i % board->gridWidth, i / board->gridWidth, player);
+        if(gamelogic_updatePlayerStatus(&child, childStatus, player))
+            continue;
+        success = bookExpand(gen, &child, childStatus, gamelogic_getNextPlayer(childStatus, player), ply+1);
+    }
+    gamelogic_freeBoard(&child);
+    return success;
+}
+
+/// @brief Compare book entries by key (qsort callback)
+static int bookCompareEntries(const void* a, const void* b)
+{
+    uint64_t keyA = ((const struct BookEntry*)a)->key;
+    uint64_t keyB = ((const struct BookEntry*)b)->key;
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+/// @brief Sort the generated entries and write them to a book file, entries with the same key (possible only with a key collision) are written once
+/// @param gen Book generator
+/// @param path Output file path
+/// @return Amount of written entries or -1 if the file couldn't be written
+static int bookWrite(struct BookGenerator* gen, const char* path)
+{
+    qsort(gen->entries, gen->entryCount, sizeof(struct BookEntry), bookCompareEntries);
+    int uniqueCount = 0;
+    for(int i=0; i<gen->entryCount; i++)
+    {
+        if(uniqueCount == 0 || gen->entries[i].key != gen->entries[uniqueCount-1].key)
+            gen->entries[uniqueCount++] = gen->entries[i];
+    }
+
+    SDL_RWops* file = SDL_RWFromFile(path, "wb");
+    if(!file)
+        return -1;
+    bool written = (SDL_RWwrite(file, BOOK_MAGIC, 1, 4) == 4);
+    written = written && SDL_WriteLE16(file, BOOK_VERSION) && SDL_WriteLE32(file, uniqueCount);
+    for(int i=0; i<uniqueCount && written; i++)
+        written = SDL_WriteLE64(file, gen->entries[i].key) && SDL_WriteLE16(file, gen->entries[i].move);
+    if(SDL_RWclose(file) != 0)
+        written = false;
+    return written ? uniqueCount : -1;
+}
+
+bool gamebookgen_generate(const char* path, int plies, int timeLimit, int threadCount)
+{
+    struct BookGenerator gen = {0};
+    gen.plies = (plies > 0) ? plies : BOOK_DEFAULT_PLIES;
+    gen.params.maxDepth = SEARCH_MAX_DEPTH;
+    gen.params.timeLimit = (timeLimit > 0) ? timeLimit : BOOK_DEFAULT_SEARCHTIME;
+    if(threadCount <= 0)
+        threadCount = SDL_GetCPUCount();
+    gen.params.threadPool = (threadCount > 1) ? kthreadpool_create(threadCount) : NULL;
+    gen.params.table = gametranstable_create((size_t)BOOK_TABLESIZE*1024*1024);
+
+    KTimer* timer = ktimer_create();
+    SDL_Log("Opening book: %d plies, %d ms per search, %d threads",gen.plies,gen.params.timeLimit,gen.params.threadPool ? kthreadpool_getThreadCount(gen.params.threadPool) : 1);
+    bool success = (timer != NULL);
+    for(int mode=EXPLOSION_SEQUENTIAL; mode<=EXPLOSION_WAVE && success; mode++)
+    {
+        for(int gridWidth=MIN_GRIDWIDTH; gridWidth<=MAX_GRIDWIDTH && success; gridWidth++)
+        {
+            for(int gridHeight=MIN_GRIDHEIGHT; gridHeight<=MAX_GRIDHEIGHT && success; gridHeight++)
+            {
+                struct KABoard board;
+                if(!gamesymmetry_init(&gen.symmetry, gridWidth, gridHeight) || !gamelogic_allocBoard(&board, gridWidth, gridHeight))
+                {
+                    gamesymmetry_free(&gen.symmetry);
+                    success = false;
+                    break;
+                }
+                board.explosionMode = mode;
+                enum PlayerStatus playerStatus[4] = {PST_NOTSTARTED, PST_NOTSTARTED, PST_NOTPRESENT, PST_NOTPRESENT};
+                gen.gridStart = gen.entryCount;
+                // Results of the previous grid size are useless for this one
+                if(gen.params.table)
+                    gametranstable_clear(gen.params.table);
+                success = bookExpand(&gen, &board, playerStatus, 0, 0);
+                gamelogic_freeBoard(&board);
+                gamesymmetry_free(&gen.symmetry);
+                SDL_Log("%s %2d x %d: %5d positions, %.0f s total",(mode == EXPLOSION_WAVE) ? "Wave" : "Sequential",gridWidth,gridHeight,
+                    gen.entryCount-gen.gridStart,ktimer_getTimeFloat(timer));
+            }
+        }
+    }
+
+    int entryCount = -1;
+    if(success)
+        entryCount = bookWrite(&gen, path);
+    if(entryCount >= 0)
+        SDL_Log("Opening book: %d positions written to %s",entryCount,path);
+    else
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gamebookgen_generate: Couldn't generate the opening book %s!",path);
+    ktimer_destroy(timer);
+    gametranstable_free(gen.params.table);
+    kthreadpool_destroy(gen.params.threadPool);
+    free(gen.entries);
+    return entryCount >= 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdbool.h>
+
+// Default amount of plies from the empty board covered by a generated book
+#define BOOK_DEFAULT_PLIES 2
+
+// Default time budget of every book search in milliseconds
+#define BOOK_DEFAULT_SEARCHTIME 2000
+
+/// @brief Generate an opening book for every grid size selectable in the menu and both explosion modes, searching every position reachable in the first plies with the difficulty 4 AI search
+/// @param path Output file path
+/// @param plies Amount of plies from the empty board covered by the book (BOOK_DEFAULT_PLIES if <= 0)
+/// @param timeLimit Time budget of every search in milliseconds (BOOK_DEFAULT_SEARCHTIME if <= 0)
+/// @param threadCount Amount of search threads (0 = one per CPU core)
+/// @return true on success, false if the book couldn't be generated or written
+bool gamebookgen_generate(const char* path, int plies, int timeLimit, int threadCount);
@@ -93,24 +93,26 @@ void gamedraw_drawGrid(void)
 
 void gamedraw_drawAtoms(void)
 {
-    SDL_Rect explodeRect = {-1,-1,11,11};
+    SDL_Rect explodeRect = {0,0,11,11};
     for(int x=0; x<logicData->gridWidth; x++)
     {
         for(int y=0; y<logicData->gridHeight; y++)
         {
-            struct KATile* curTile = &logicData->tiles[x][y];
+            int index = BOARD_INDEX(&logicData->board,x,y);
+            struct KATile* curTile = &logicData->tiles[index];
             int basex = gridStartX+(x*TILESIZE);
             int basey = gridStartY+(y*TILESIZE);
             if(curTile->explodeTime > 0)
             {
                 explodeRect.x = 10+basex;
                 explodeRect.y = 10+basey;
+                SDL_RenderCopy(gameRenderer, texExplode, NULL, &explodeRect);
             }
-            else if(curTile->playerNum >= 0)
+            else if(logicData->board.owner[index] != NOOWNER)
             {
-                const SDL_Color* atomColor = &atomPlayerColors[curTile->playerNum];
+                const SDL_Color* atomColor = &atomPlayerColors[logicData->board.owner[index]];
                 SDL_SetTextureColorMod(texAtom, atomColor->r, atomColor->g, atomColor->b);
-                int visibleAtomCount = SDL_min(curTile->atomCount,MAX_VISIBLE_ATOMS);
+                int visibleAtomCount = SDL_min(logicData->board.count[index],MAX_VISIBLE_ATOMS);
                 for(int i=0; i<visibleAtomCount; i++)
                 {
                     struct KAAtom* curAtom = &curTile->atoms[i];
@@ -120,8 +122,6 @@ void gamedraw_drawAtoms(void)
             }
         }
     }
-    if(explodeRect.x >= 0)
-        SDL_RenderCopy(gameRenderer, texExplode, NULL, &explodeRect);
 }
 
 void gamedraw_drawHUD(Sint32 gameTime)
@@ -0,0 +1,162 @@
+#include "gameeval.h"
+#include <SDL2/SDL.h>
+#include <string.h>
+
+// Size of the weights file header (magic number, version and feature count)
+#define EVAL_HEADER_SIZE 8
+
+const struct EvalWeights gameeval_defaultWeights = EVAL_DEFAULT_WEIGHTS;
+
+/// @brief Get the critical atom amount of a board tile
+/// @param board Compact board
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @return Critical atom amount (2 for corners, 3 for sides, 4 otherwise)
+static int evalGetCrit(const struct KABoard* board, int x, int y)
+{
+    return 4 - (x == 0 || x == board->gridWidth-1) - (y == 0 || y == board->gridHeight-1);
+}
+
+void gameeval_getFeatures(const struct KABoard* board, int features[4][EVAL_FEATURE_COUNT])
+{
+    memset(features, 0, 4*sizeof(features[0]));
+    int ownedTiles[4] = {0};
+    for(int y=0; y<board->gridHeight; y++)
+    {
+        for(int x=0; x<board->gridWidth; x++)
+        {
+            int index = BOARD_INDEX(board,x,y);
+            int player = board->owner[index];
+            if(player == NOOWNER)
+                continue;
+            ownedTiles[player]++;
+            int crit = evalGetCrit(board,x,y);
+            int nearbyTiles[4];
+            int nearbyCrit[4];
+            int nearbyTileCount = 0;
+            if(y > 0)
+            {
+                nearbyCrit[nearbyTileCount] = evalGetCrit(board,x,y-1);
+                nearbyTiles[nearbyTileCount++] = index-board->gridWidth;
+            }
+            if(y < board->gridHeight-1)
+            {
+                nearbyCrit[nearbyTileCount] = evalGetCrit(board,x,y+1);
+                nearbyTiles[nearbyTileCount++] = index+board->gridWidth;
+            }
+            if(x > 0)
+            {
+                nearbyCrit[nearbyTileCount] = evalGetCrit(board,x-1,y);
+                nearbyTiles[nearbyTileCount++] = index-1;
+            }
+            if(x < board->gridWidth-1)
+            {
+                nearbyCrit[nearbyTileCount] = evalGetCrit(board,x+1,y);
+                nearbyTiles[nearbyTileCount++] = index+1;
+            }
+
+            bool threatened = false;
+            bool advantage = false;
+            for(int i=0; i<nearbyTileCount; i++)
+            {
+                int nindex = nearbyTiles[i];
+                int ncrit = nearbyCrit[i];
+                if(board->owner[nindex] == NOOWNER || board->owner[nindex] == player)
+                    continue;
+                if((int)board->count[nindex] == ncrit-1)
+                {
+                    features[player][(ncrit == 2) ? EVAL_CORNERTHREATS : (ncrit == 3) ? EVAL_SIDETHREATS : EVAL_CENTERTHREATS]++;
+                    threatened = true;
+                }
+                if((int)board->count[index]-crit >= (int)board->count[nindex]-ncrit)
+                    advantage = true;
+            }
+            if(advantage)
+                features[player][EVAL_ADVANTAGE]++;
+            if(!threatened)
+            {
+                if(crit == 2)
+                    features[player][EVAL_SAFECORNERS]++;
+                else if(crit == 3)
+                    features[player][EVAL_SAFESIDES]++;
+                if((int)board->count[index] == crit-1)
+                    features[player][EVAL_SAFEPRECRIT]++;
+            }
+        }
+    }
+
+    int tileCount = board->gridWidth*board->gridHeight;
+    int totalOwnedTiles = ownedTiles[0]+ownedTiles[1]+ownedTiles[2]+ownedTiles[3];
+    for(int p=0; p<4; p++)
+    {
+        features[p][EVAL_ATOMS] = board->playerAtoms[p];
+        features[p][EVAL_MOBILITY] = tileCount-totalOwnedTiles+ownedTiles[p];
+    }
+}
+
+int gameeval_evaluate(const struct EvalWeights* weights, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player)
+{
+    if(!weights)
+        weights = &gameeval_defaultWeights;
+    int features[4][EVAL_FEATURE_COUNT];
+    gameeval_getFeatures(board, features);
+    int scores[4] = {0};
+    for(int p=0; p<4; p++)
+    {
+        // Players who aren't in the game anymore aren't scored
+        if(p != player && playerStatus[p] <= PST_LOST)
+            continue;
+        for(int i=0; i<EVAL_FEATURE_COUNT; i++)
+            scores[p] += weights->weights[i]*features[p][i];
+    }
+
+    int bestEnemyScore = 0;
+    bool enemyFound = false;
+    for(int p=0; p<4; p++)
+    {
+        if(p == player || playerStatus[p] <= PST_LOST)
+            continue;
+        if(!enemyFound || scores[p] > bestEnemyScore)
+            bestEnemyScore = scores[p];
+        enemyFound = true;
+    }
+    return scores[player] - bestEnemyScore;
+}
+
+bool gameeval_loadWeights(struct EvalWeights* weights, const void* data, size_t size)
+{
+    SDL_RWops* stream = SDL_RWFromConstMem(data, (int)size);
+    if(!stream)
+        return false;
+    char magic[4];
+    bool valid = (size >= EVAL_HEADER_SIZE && SDL_RWread(stream, magic, 1, 4) == 4 && memcmp(magic, EVAL_MAGIC, 4) == 0 && SDL_ReadLE16(stream) == EVAL_VERSION);
+    int featureCount = valid ? SDL_ReadLE16(stream) : 0;
+    valid = valid && (size_t)featureCount*4 <= size-EVAL_HEADER_SIZE;
+    if(valid)
+    {
+        // Files written by newer versions can have more features, they're ignored
+        *weights = gameeval_defaultWeights;
+        for(int i=0; i<featureCount; i++)
+        {
+            int32_t weight = (int32_t)SDL_ReadLE32(stream);
+            if(i < EVAL_FEATURE_COUNT)
+                weights->weights[i] = weight;
+        }
+    }
+    SDL_RWclose(stream);
+    return valid;
+}
+
+bool gameeval_saveWeights(const struct EvalWeights* weights, const char* path)
+{
+    SDL_RWops* file = SDL_RWFromFile(path, "wb");
+    if(!file)
+        return false;
+    bool written = (SDL_RWwrite(file, EVAL_MAGIC, 1, 4) == 4);
+    written = written && SDL_WriteLE16(file, EVAL_VERSION) && SDL_WriteLE16(file, EVAL_FEATURE_COUNT);
+    for(int i=0; i<EVAL_FEATURE_COUNT && written; i++)
+        written = SDL_WriteLE32(file, (uint32_t)weights->weights[i]);
+    if(SDL_RWclose(file) != 0)
+        written = false;
+    return written;
+}
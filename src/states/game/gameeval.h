@@ -0,0 +1,76 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include "gamelogic.h"
+
+// Evaluation weights file magic number
+#define EVAL_MAGIC "KAEW"
+
+// Evaluation weights file format version, has to be raised when the file layout or the meaning of a feature changes
+#define EVAL_VERSION 1
+
+// Default weight of a single atom, the default weights of the other features are relative to it
+#define EVAL_WEIGHT_SCALE 16
+
+// Position features counted for every player, a tile is threatened if a nearby enemy tile is 1 atom away from exploding
+enum EvalFeature {
+    EVAL_ATOMS,             //Atoms of the player
+    EVAL_MOBILITY,          //Legal moves of the player (empty tiles and tiles of the player)
+    EVAL_SAFECORNERS,       //Corner tiles of the player that aren't threatened
+    EVAL_SAFESIDES,         //Side tiles of the player that aren't threatened
+    EVAL_SAFEPRECRIT,       //Tiles of the player 1 atom away from exploding that aren't threatened
+    EVAL_CORNERTHREATS,     //Enemy corner tiles 1 atom away from exploding next to a tile of the player (counted for every tile they threaten)
+    EVAL_SIDETHREATS,       //Enemy side tiles 1 atom away from exploding next to a tile of the player
+    EVAL_CENTERTHREATS,     //Enemy center tiles 1 atom away from exploding next to a tile of the player
+    EVAL_ADVANTAGE,         //Tiles of the player at least as close to exploding as a nearby enemy tile
+    EVAL_FEATURE_COUNT
+};
+
+// Weights of the linear position evaluation, a player score is the sum of its features multiplied by their weights
+struct EvalWeights {
+    int weights[EVAL_FEATURE_COUNT];
+};
+
+// Initializer of the hand-tuned default weights, same scores as the original hard-coded search evaluation: atoms, safe tiles worth more on corners and sides
+// and when they're about to explode, and tiles next to an enemy tile that's about to explode being likely to be taken over
+#define EVAL_DEFAULT_WEIGHTS {{ \
+    [EVAL_ATOMS] = EVAL_WEIGHT_SCALE, \
+    [EVAL_MOBILITY] = 0, \
+    [EVAL_SAFECORNERS] = 2*EVAL_WEIGHT_SCALE, \
+    [EVAL_SAFESIDES] = EVAL_WEIGHT_SCALE, \
+    [EVAL_SAFEPRECRIT] = 2*EVAL_WEIGHT_SCALE, \
+    [EVAL_CORNERTHREATS] = -3*EVAL_WEIGHT_SCALE, \
+    [EVAL_SIDETHREATS] = -2*EVAL_WEIGHT_SCALE, \
+    [EVAL_CENTERTHREATS] = -EVAL_WEIGHT_SCALE, \
+    [EVAL_ADVANTAGE] = 0 \
+}}
+
+// Hand-tuned weights used when no weights file is loaded (EVAL_DEFAULT_WEIGHTS)
+extern const struct EvalWeights gameeval_defaultWeights;
+
+/// @brief Count the features of every player on a board
+/// @param board Board
+/// @param features Feature counts to write for every player
+void gameeval_getFeatures(const struct KABoard* board, int features[4][EVAL_FEATURE_COUNT]);
+
+/// @brief Score a position from the point of view of a player
+/// @param weights Evaluation weights (NULL = gameeval_defaultWeights)
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @param player Player the position is scored for
+/// @return Player score minus the score of the strongest opponent still in the game
+int gameeval_evaluate(const struct EvalWeights* weights, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player);
+
+/// @brief Load evaluation weights from memory, features missing in the file keep their default weights
+/// @param weights Weights to write
+/// @param data Weights file data
+/// @param size Weights file size in bytes
+/// @return true on success, false if the data is invalid (the weights aren't changed then)
+bool gameeval_loadWeights(struct EvalWeights* weights, const void* data, size_t size);
+
+/// @brief Write evaluation weights to a file.
+/// The file starts with EVAL_MAGIC, the version and the feature count (LE16 each), followed by the weight of every feature (LE32, two's complement).
+/// @param weights Evaluation weights
+/// @param path Output file path
+/// @return true on success, false if the file couldn't be written
+bool gameeval_saveWeights(const struct EvalWeights* weights, const char* path);
@@ -1,10 +1,9 @@
 #include "gamelogic.h"
-#include "../../game/state.h"
-#include "../../game/game.h"
-#include "../../utils/wavplayer.h"
 #include "gameai.h"
+#include "gamebitboard.h"
 #include <SDL2/SDL.h>
-#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 // Base atom speed in pixels per second
@@ -18,18 +17,313 @@ const static int atomEndPos = 18;
 
 struct GameLogicData* logicData = NULL;
 
+// Presentation callbacks (NULL = log messages and errors only)
+static const struct GamePresenter* presenter = NULL;
+
 // Order of nearby critical tile checks during chain reactions (stored as position offsets from checked tile)
 const static Vec2 checkTab[4] = {
     {0,1},{0,-1},{1,0},{-1,0}
 };
 
+// Initial capacity of the chain reaction stack used by gamelogic_resolveMove
+#define RESOLVESTACKSIZE 256
+
+// Growable stack of tile indices used to resolve chain reactions without animations
+struct ResolveStack {
+    int* items;                         //Stack items (points to localItems until the stack has to grow)
+    int count;                          //Current stack item count
+    int capacity;                       //Max item count before the stack has to grow
+    int localItems[RESOLVESTACKSIZE];   //Initial stack storage
+};
+
+/// @brief Push a tile index onto the resolve stack, growing it if necessary
+/// @param stack Resolve stack
+/// @param index Tile index
+/// @return true on success, false if the stack couldn't grow
+static bool resolveStackPush(struct ResolveStack* stack, int index)
+{
+    if(stack->count >= stack->capacity)
+    {
+        int newCapacity = stack->capacity*2;
+        int* newItems = (stack->items == stack->localItems) ? malloc(newCapacity*sizeof(int)) : realloc(stack->items, newCapacity*sizeof(int));
+        if(!newItems)
+            return false;
+        if(stack->items == stack->localItems)
+            memcpy(newItems, stack->localItems, sizeof(stack->localItems));
+        stack->items = newItems;
+        stack->capacity = newCapacity;
+    }
+    stack->items[stack->count++] = index;
+    return true;
+}
+
+/// @brief Free the resolve stack items if the stack had to grow
+/// @param stack Resolve stack
+static void resolveStackFree(struct ResolveStack* stack)
+{
+    if(stack->items != stack->localItems)
+        free(stack->items);
+    stack->items = stack->localItems;
+    stack->capacity = RESOLVESTACKSIZE;
+}
+
+/// @brief Show an info message through the presenter
+/// @param str Message string
+/// @param time Time to show the message for in seconds
+static void printMsg(const char* str, float time)
+{
+    if(presenter && presenter->printMsg)
+        presenter->printMsg(str, time);
+    else
+        SDL_Log("%s",str);
+}
+
+/// @brief Send a game event to the presenter
+/// @param event Game event
+/// @param tileCount Amount of tiles the event happened on
+static void sendEvent(enum GameEvent event, int tileCount)
+{
+    if(presenter && presenter->gameEvent)
+        presenter->gameEvent(event, tileCount);
+}
+
+// Seed mixed into every Zobrist key
+#define ZOBRIST_SEED 0x4B6C656C6541746FULL
+
+/// @brief Get the Zobrist key of a key state, different states always give different keys (splitmix64 finalizer)
+/// @param state Key state: tile index, owner and atom count or a state past every tile for the player keys
+/// @return Zobrist key
+static uint64_t zobristKey(uint64_t state)
+{
+    uint64_t value = state*0x9E3779B97F4A7C15ULL + ZOBRIST_SEED;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// Keys are computed instead of looked up, so they work for any grid size without a table
+uint64_t gamelogic_getTileKey(int index, int owner, int count)
+{
+    if(owner == NOOWNER || count <= 0)
+        return 0;
+    return zobristKey(((uint64_t)index << 6) | ((uint64_t)owner << 3) | SDL_min(count, ZOBRIST_MAX_COUNT));
+}
+
+uint64_t gamelogic_getPositionKey(const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player)
+{
+    // Player key states come after the states of every tile, followed by the grid size and explosion mode states
+    // (a table kept between games must not mix up equal tiles of different grids or rules)
+    const uint64_t playerState = (uint64_t)MAX_GRID_WIDTH*MAX_GRID_HEIGHT << 6;
+    const uint64_t gridState = playerState + 8;
+    uint64_t key = board->hash ^ zobristKey(playerState + player);
+    for(int p=0; p<4; p++)
+    {
+        if(playerStatus[p] == PST_NOTSTARTED)
+            key ^= zobristKey(playerState + 4 + p);
+    }
+    uint64_t grid = (uint64_t)(board->gridWidth-1)*MAX_GRID_HEIGHT + (board->gridHeight-1);
+    return key ^ zobristKey(gridState + grid*2 + (board->explosionMode == EXPLOSION_WAVE));
+}
+
+/// @brief Get the critical atom amount of a board tile
+/// @param board Compact board
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @return Critical atom amount (2 for corners, 3 for sides, 4 otherwise)
+static int boardGetCrit(const struct KABoard* board, int x, int y)
+{
+    return 4 - (x == 0 || x == board->gridWidth-1) - (y == 0 || y == board->gridHeight-1);
+}
+
+/// @brief Check if a player has won: the player owns every atom and every other remaining player has already placed atoms
+/// @param board Compact board
+/// @param playerStatus Player statuses
+/// @param player Player to check
+/// @return true if the player has won, false otherwise
+static bool boardIsWinning(const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player)
+{
+    for(int i=0; i<4; i++)
+    {
+        if(i == player)
+            continue;
+        if(playerStatus[i] == PST_NOTSTARTED)
+            return false;
+        if(playerStatus[i] == PST_PLAYING && board->playerAtoms[i] > 0)
+            return false;
+    }
+    return true;
+}
+
+/// @brief Replace the contents of a board tile
+/// @param board Compact board
+/// @param index Tile index
+/// @param player New tile player (ignored if count is 0)
+/// @param count New atom count
+static void boardSetAtoms(struct KABoard* board, int index, int player, int count)
+{
+    board->hash ^= gamelogic_getTileKey(index, board->owner[index], board->count[index]);
+    if(board->owner[index] != NOOWNER)
+        board->playerAtoms[board->owner[index]] -= board->count[index];
+    if(player < 0 || player > 3 || count <= 0)
+    {
+        board->owner[index] = NOOWNER;
+        board->count[index] = 0;
+        return;
+    }
+    board->owner[index] = player;
+    board->count[index] = count;
+    board->playerAtoms[player] += board->count[index];
+    board->hash ^= gamelogic_getTileKey(index, player, board->count[index]);
+}
+
+/// @brief Put atoms on a board tile and give all of its atoms to a given player
+/// @param board Compact board
+/// @param index Tile index
+/// @param player New tile player
+/// @param count How many atoms will be placed
+static void boardPutAtoms(struct KABoard* board, int index, int player, int count)
+{
+    int oldCount = board->count[index];
+    board->hash ^= gamelogic_getTileKey(index, board->owner[index], oldCount);
+    if(board->owner[index] != NOOWNER)
+        board->playerAtoms[board->owner[index]] -= oldCount;
+    int newCount = oldCount+count;
+    board->owner[index] = player;
+    board->count[index] = newCount;
+    board->playerAtoms[player] += newCount;
+    board->hash ^= gamelogic_getTileKey(index, player, newCount);
+}
+
+/// @brief Blow up a board tile, spreading its atoms to nearby tiles (down, up, right, left - extra atoms go to the first one)
+/// @param board Compact board
+/// @param x Tile X position
+/// @param y Tile Y position
+static void boardExplode(struct KABoard* board, int x, int y)
+{
+    int index = BOARD_INDEX(board,x,y);
+    int player = board->owner[index];
+    int extra = SDL_max((int)board->count[index]-boardGetCrit(board,x,y),0);
+    board->playerAtoms[player] -= board->count[index];
+    board->hash ^= gamelogic_getTileKey(index, player, board->count[index]);
+    board->owner[index] = NOOWNER;
+    board->count[index] = 0;
+    if(y < board->gridHeight-1)
+        { boardPutAtoms(board,index+board->gridWidth,player,extra+1); extra = 0; }
+    if(y > 0)
+        { boardPutAtoms(board,index-board->gridWidth,player,extra+1); extra = 0; }
+    if(x < board->gridWidth-1)
+        { boardPutAtoms(board,index+1,player,extra+1); extra = 0; }
+    if(x > 0)
+        { boardPutAtoms(board,index-1,player,extra+1); extra = 0; }
+}
+
+/// @brief Checks if any surrounding tiles are critical
+/// @param board Compact board
+/// @param index Base tile index
+/// @return Index of a surrounding tile that's critical or -1 if none of those tiles is critical
+static int boardCheckSurrounding(const struct KABoard* board, int index)
+{
+    int x = index % board->gridWidth;
+    int y = index / board->gridWidth;
+    for(int i=0; i<4; i++)
+    {
+        int nx = x+checkTab[i].x;
+        int ny = y+checkTab[i].y;
+        if(nx >= 0 && nx < board->gridWidth && ny >= 0 && ny < board->gridHeight)
+        {
+            int nindex = BOARD_INDEX(board,nx,ny);
+            if(board->owner[nindex] != NOOWNER && (int)board->count[nindex] >= boardGetCrit(board,nx,ny))
+                return nindex;
+        }
+    }
+    return -1;
+}
+
+/// @brief Collect every critical tile of a board as the next explosion wave
+/// @param board Compact board
+/// @param wave Resolve stack to push (tile index, extra atom count) pairs onto, in tile index order
+/// @return true on success, false if the stack couldn't grow
+static bool boardCollectWave(const struct KABoard* board, struct ResolveStack* wave)
+{
+    for(int y=0; y<board->gridHeight; y++)
+    {
+        for(int x=0; x<board->gridWidth; x++)
+        {
+            int index = BOARD_INDEX(board,x,y);
+            int crit = boardGetCrit(board,x,y);
+            if(board->owner[index] == NOOWNER || (int)board->count[index] < crit)
+                continue;
+            if(!resolveStackPush(wave,index) || !resolveStackPush(wave,(int)board->count[index]-crit))
+                return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Blow up every tile of a wave at the same time (same rules as boardExplode, but no tile of the wave gets atoms before all of them are emptied)
+/// @param board Compact board
+/// @param player Player the explosions belong to
+/// @param wave Wave collected by boardCollectWave
+static void boardExplodeWave(struct KABoard* board, int player, const struct ResolveStack* wave)
+{
+    for(int i=0; i<wave->count; i+=2)
+        boardSetAtoms(board,wave->items[i],NOPLAYER,0);
+    for(int i=0; i<wave->count; i+=2)
+    {
+        int index = wave->items[i];
+        int extra = wave->items[i+1];
+        int x = index % board->gridWidth;
+        int y = index / board->gridWidth;
+        if(y < board->gridHeight-1)
+            { boardPutAtoms(board,index+board->gridWidth,player,extra+1); extra = 0; }
+        if(y > 0)
+            { boardPutAtoms(board,index-board->gridWidth,player,extra+1); extra = 0; }
+        if(x < board->gridWidth-1)
+            { boardPutAtoms(board,index+1,player,extra+1); extra = 0; }
+        if(x > 0)
+            { boardPutAtoms(board,index-1,player,extra+1); extra = 0; }
+    }
+}
+
+/// @brief Resolve a chain reaction wave by wave without animations (EXPLOSION_WAVE mode)
+/// @param board Compact board with the new atom already placed
+/// @param playerStatus Player statuses before the move
+/// @param player Player making the move
+/// @return Amount of explosions
+static int boardResolveWaves(struct KABoard* board, const enum PlayerStatus playerStatus[4], int player)
+{
+    struct ResolveStack wave;
+    wave.items = wave.localItems;
+    wave.capacity = RESOLVESTACKSIZE;
+    int explosionCount = 0;
+    while(true)
+    {
+        wave.count = 0;
+        if(!boardCollectWave(board,&wave))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"resolveMove: couldn't allocate explosion wave");
+            break;
+        }
+        if(wave.count == 0)
+            break;
+        boardExplodeWave(board,player,&wave);
+        explosionCount += wave.count/2;
+
+        // The player has won, so the chain reaction can't change the result anymore (like checkEarlyWin in the game)
+        if(boardIsWinning(board,playerStatus,player))
+            break;
+    }
+    resolveStackFree(&wave);
+    return explosionCount;
+}
+
 // Switch the current player to the next one and reset AI timer
 static void nextPlayer(void)
-{   
+{
     ai_ResetTime();
     if(logicData->curPlayerCount < 2)
         return;
-    
+
     do
     {
         logicData->curPlayer++;
@@ -38,62 +332,78 @@ static void nextPlayer(void)
     while(logicData->playerStatus[logicData->curPlayer] <= PST_LOST);
 }
 
-/// @brief Put an atom (or multiple atoms) on a given tile and play atom animations
+/// @brief Add a tile to the list of animating tiles (if it isn't there already)
 /// @param x Tile X position
 /// @param y Tile Y position
-/// @param newPlayer Set the player the atoms on that tile will belong to. If newPlayer == NOPLAYER, newPlayer is current player.
-/// @param count How many atoms will be placed
-/// @return true if the tile becomes (or is) critical
-static bool putAtom(int x, int y, int newPlayer, int count)
+static void markTileAnimating(int x, int y)
 {
-    if(x < 0 || x >= logicData->gridWidth || y < 0 || y >= logicData->gridHeight)
+    struct KATile* curTile = &logicData->tiles[BOARD_INDEX(&logicData->board,x,y)];
+    if(!curTile->animating)
     {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"putAtom: invalid position (%d, %d)",x,y);
-        return false;
+        curTile->animating = true;
+        logicData->animTiles[logicData->animTileCount++] = BOARD_INDEX(&logicData->board,x,y);
     }
-    struct KATile* curTile = &logicData->tiles[x][y];
+    logicData->animPlaying = true;
+}
 
-    int oldPlayer = curTile->playerNum;
-    if(newPlayer == NOPLAYER)
-        curTile->playerNum = logicData->curPlayer;
-    else
-        curTile->playerNum = newPlayer;
-    int atPlayer = curTile->playerNum;
-    for(int i=0; i<count; i++)
+/// @brief Animate atoms added to a tile since the board had oldCount atoms on it
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @param oldCount Atom count before the board change
+static void animAddAtoms(int x, int y, int oldCount)
+{
+    struct KATile* curTile = &logicData->tiles[BOARD_INDEX(&logicData->board,x,y)];
+    int newCount = SDL_min(logicData->board.count[BOARD_INDEX(&logicData->board,x,y)], MAX_VISIBLE_ATOMS);
+    if(newCount > oldCount)
+        markTileAnimating(x, y);
+    for(int atomCount=oldCount; atomCount<newCount; atomCount++)
     {
-        if(curTile->atomCount >= MAX_VISIBLE_ATOMS)
-        {
-            curTile->atomCount++;
-            continue;
-        }
-
-        switch(curTile->atomCount)
+        switch(atomCount)
         {
             case 0:
-                curTile->atoms[curTile->atomCount++] = (struct KAAtom){atomMidPos,atomMidPos,atomMidPos,atomMidPos};
+                curTile->atoms[atomCount] = (struct KAAtom){atomMidPos,atomMidPos,atomMidPos,atomMidPos};
                 break;
             case 1:
-                logicData->animPlaying = true;
                 curTile->atoms[0].endx = atomEndPos;
-                curTile->atoms[curTile->atomCount++] = (struct KAAtom){atomMidPos,atomMidPos,2,atomMidPos};
+                curTile->atoms[atomCount] = (struct KAAtom){atomMidPos,atomMidPos,2,atomMidPos};
                 break;
             case 2:
-                logicData->animPlaying = true;
                 curTile->atoms[0].endy = 2;
                 curTile->atoms[1].endy = 2;
-                curTile->atoms[curTile->atomCount++] = (struct KAAtom){atomMidPos,atomMidPos,atomMidPos,atomEndPos};
+                curTile->atoms[atomCount] = (struct KAAtom){atomMidPos,atomMidPos,atomMidPos,atomEndPos};
                 break;
             case 3:
-                logicData->animPlaying = true;
                 curTile->atoms[2].endx = 2;
-                curTile->atoms[curTile->atomCount++] = (struct KAAtom){atomMidPos,atomEndPos,atomEndPos,atomEndPos};
+                curTile->atoms[atomCount] = (struct KAAtom){atomMidPos,atomEndPos,atomEndPos,atomEndPos};
                 break;
             default:
-                curTile->atoms[curTile->atomCount++] = (struct KAAtom){atomMidPos,atomMidPos,(rand() % 11)+5,(rand() % 11)+5};
+                curTile->atoms[atomCount] = (struct KAAtom){atomMidPos,atomMidPos,krandom_range(&logicData->random,11)+5,krandom_range(&logicData->random,11)+5};
                 break;
         }
     }
-    return (atPlayer != NOPLAYER && curTile->atomCount >= logicData->critGrid[x][y]);
+}
+
+/// @brief Put an atom (or multiple atoms) on a given tile and play atom animations
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @param newPlayer Set the player the atoms on that tile will belong to. If newPlayer == NOPLAYER, newPlayer is current player.
+/// @param count How many atoms will be placed
+/// @return true if the tile becomes (or is) critical
+static bool putAtom(int x, int y, int newPlayer, int count)
+{
+    if(x < 0 || x >= logicData->gridWidth || y < 0 || y >= logicData->gridHeight)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"putAtom: invalid position (%d, %d)",x,y);
+        return false;
+    }
+    struct KABoard* board = &logicData->board;
+    int index = BOARD_INDEX(board,x,y);
+
+    int oldCount = board->count[index];
+    boardPutAtoms(board, index, (newPlayer == NOPLAYER) ? logicData->curPlayer : newPlayer, count);
+    ai_TileChanged(x, y);
+    animAddAtoms(x, y, oldCount);
+    return ((int)board->count[index] >= logicData->critGrid[index]);
 }
 
 /// @brief Blow up a critical tile, which spreads the atoms to nearby tiles
@@ -102,45 +412,163 @@ static bool putAtom(int x, int y, int newPlayer, int count)
 static void explodeAtoms(int x, int y)
 {
     logicData->explosionCount++;
-    struct KATile* curTile = &logicData->tiles[x][y];
+    struct KATile* curTile = &logicData->tiles[BOARD_INDEX(&logicData->board,x,y)];
     float explosionTimeMultiplier = SDL_min(logicData->explosionCount,1000)/10.0f;
     curTile->explodeTime = 0.3f/SDL_max(explosionTimeMultiplier,1);
-    int atplayer = curTile->playerNum;
-    int extra = SDL_max(curTile->atomCount-logicData->critGrid[x][y],0);
-    if(y < logicData->gridHeight-1)
-        { putAtom(x,y+1,atplayer,extra+1); extra = 0; }
-    if(y > 0)
-        { putAtom(x,y-1,atplayer,extra+1); extra = 0; }
-    if(x < logicData->gridWidth-1)
-        { putAtom(x+1,y,atplayer,extra+1); extra = 0; }
-    if(x > 0)
-        { putAtom(x-1,y,atplayer,extra+1); extra = 0; }
-    curTile->playerNum = NOPLAYER;
-    curTile->atomCount = 0;
-    if(logicData->explosionCount < 1000)
-        wavplayer_play(sfxExplode);
-}
+    markTileAnimating(x, y);
 
-/// @brief Checks if any surrounding tiles are critical
-/// @param x Base tile X position
-/// @param y Base tile Y position
-/// @return Position of a surrounding tile that's critical or [INT_MAX, INT_MAX] vector if none of those tiles is critical
-static Vec2 checkSurrounding(int x, int y)
-{
+    // Apply the explosion to the rules board, then animate the atoms it gave to the nearby tiles
+    struct KABoard* board = &logicData->board;
+    int oldCounts[4];
+    for(int i=0; i<4; i++)
+    {
+        int nx = x+checkTab[i].x;
+        int ny = y+checkTab[i].y;
+        if(nx >= 0 && nx < logicData->gridWidth && ny >= 0 && ny < logicData->gridHeight)
+            oldCounts[i] = board->count[BOARD_INDEX(board,nx,ny)];
+    }
+    boardExplode(board, x, y);
+    ai_TileChanged(x, y);
     for(int i=0; i<4; i++)
     {
         int nx = x+checkTab[i].x;
         int ny = y+checkTab[i].y;
         if(nx >= 0 && nx < logicData->gridWidth && ny >= 0 && ny < logicData->gridHeight)
         {
-            struct KATile* curTile = &logicData->tiles[nx][ny];
-            if(curTile->playerNum != NOPLAYER && curTile->atomCount >= logicData->critGrid[nx][ny])
+            ai_TileChanged(nx, ny);
+            animAddAtoms(nx, ny, oldCounts[i]);
+        }
+    }
+    sendEvent(GEV_EXPLOSION, 1);
+}
+
+/// @brief Push a tile position onto the atom stack, growing the stack if it's full
+/// @param tilePos Tile position
+static void pushAtomStack(Vec2 tilePos)
+{
+    if(logicData->atomStackPos >= logicData->atomStackSize)
+    {
+        int newSize = logicData->atomStackSize*2;
+        Vec2* newStack = realloc(logicData->atomStack, newSize*sizeof(Vec2));
+        if(!newStack)
+        {
+            gamelogic_errorMsg("Game: Couldn't grow the atom stack to %d entries!",newSize);
+            return;
+        }
+        logicData->atomStack = newStack;
+        logicData->atomStackSize = newSize;
+    }
+    logicData->atomStack[logicData->atomStackPos++] = tilePos;
+}
+
+/// @brief Blow up every critical tile at the same time and queue the critical tiles of the next wave on the atom stack (EXPLOSION_WAVE mode)
+static void explodeWave(void)
+{
+    struct KABoard* board = &logicData->board;
+    struct ResolveStack wave;
+    wave.items = wave.localItems;
+    wave.count = 0;
+    wave.capacity = RESOLVESTACKSIZE;
+    if(!boardCollectWave(board,&wave))
+    {
+        resolveStackFree(&wave);
+        gamelogic_errorMsg("Game: Couldn't allocate the explosion wave!");
+        return;
+    }
+
+    logicData->explosionCount += wave.count/2;
+    float explosionTimeMultiplier = SDL_min(logicData->explosionCount,1000)/10.0f;
+    uint32_t* oldCounts = logicData->waveCounts;
+    memcpy(oldCounts, board->count, board->gridWidth*board->gridHeight*sizeof(uint32_t));
+    for(int i=0; i<wave.count; i+=2)
+    {
+        int index = wave.items[i];
+        logicData->tiles[index].explodeTime = 0.3f/SDL_max(explosionTimeMultiplier,1);
+        markTileAnimating(index % board->gridWidth, index / board->gridWidth);
+        oldCounts[index] = 0;
+    }
+
+    // Apply the whole wave to the rules board, then animate the atoms every nearby tile got (once per tile)
+    boardExplodeWave(board, logicData->curPlayer, &wave);
+    for(int i=0; i<wave.count; i+=2)
+    {
+        int x = wave.items[i] % board->gridWidth;
+        int y = wave.items[i] / board->gridWidth;
+        ai_TileChanged(x, y);
+        for(int j=0; j<4; j++)
+        {
+            int nx = x+checkTab[j].x;
+            int ny = y+checkTab[j].y;
+            if(nx >= 0 && nx < logicData->gridWidth && ny >= 0 && ny < logicData->gridHeight)
             {
-                return (Vec2){nx,ny};
+                int nindex = BOARD_INDEX(board,nx,ny);
+                ai_TileChanged(nx, ny);
+                animAddAtoms(nx, ny, oldCounts[nindex]);
+                oldCounts[nindex] = board->count[nindex];
             }
         }
     }
-    return (Vec2){INT_MAX,INT_MAX};
+    sendEvent(GEV_EXPLOSION, wave.count/2);
+
+    logicData->atomStackPos = 0;
+    wave.count = 0;
+    if(!boardCollectWave(board,&wave))
+    {
+        resolveStackFree(&wave);
+        gamelogic_errorMsg("Game: Couldn't allocate the explosion wave!");
+        return;
+    }
+    for(int i=0; i<wave.count; i+=2)
+        pushAtomStack((Vec2){wave.items[i] % board->gridWidth, wave.items[i] / board->gridWidth});
+    resolveStackFree(&wave);
+}
+
+/// @brief Checks if the current player has won (owns every atom and every other remaining player has already placed atoms)
+/// @return true if the game is won, false otherwise
+static bool isCurPlayerWinning(void)
+{
+    return boardIsWinning(&logicData->board, logicData->playerStatus, logicData->curPlayer);
+}
+
+// Finish all atom movement and explosion animations instantly
+static void skipAnimations(void)
+{
+    for(int i=0; i<logicData->animTileCount; i++)
+    {
+        int index = logicData->animTiles[i];
+        struct KATile* curTile = &logicData->tiles[index];
+        curTile->explodeTime = 0;
+        curTile->animating = false;
+        for(int j=0; j<MAX_VISIBLE_ATOMS; j++)
+        {
+            curTile->atoms[j].curx = curTile->atoms[j].endx;
+            curTile->atoms[j].cury = curTile->atoms[j].endy;
+        }
+    }
+    logicData->animTileCount = 0;
+    logicData->animPlaying = false;
+}
+
+/// @brief Ends the game right away if the current player has won, without waiting for the rest of the chain reaction
+/// @return true if the game has ended, false otherwise
+static bool checkEarlyWin(void)
+{
+    if(!isCurPlayerWinning())
+        return false;
+
+    for(int i=0; i<4; i++)
+    {
+        if(i != logicData->curPlayer && logicData->playerStatus[i] == PST_PLAYING)
+        {
+            logicData->playerStatus[i] = PST_LOST;
+            logicData->curPlayerCount--;
+        }
+    }
+    logicData->playerWon = logicData->curPlayer;
+    logicData->atomStackPos = 0;
+    logicData->willExplode.explode = false;
+    skipAnimations();
+    return true;
 }
 
 /// @brief Put an atom and mark the tile for explosion if critical
@@ -149,11 +577,12 @@ static Vec2 checkSurrounding(int x, int y)
 static void prepareNewAtoms(int x, int y)
 {
     Vec2 tilePos = {x,y};
-    logicData->playerAtoms[logicData->curPlayer] = SDL_max(logicData->playerAtoms[logicData->curPlayer], 1);
     if(putAtom(x,y,NOPLAYER,1))
     {
-        logicData->willExplode = (struct KAWillExplode){tilePos.x,tilePos.y,true};
-        logicData->atomStack[logicData->atomStackPos++] = tilePos;
+        // In EXPLOSION_WAVE mode the atom stack holds the next wave, so the tile explodes with it
+        if(logicData->board.explosionMode == EXPLOSION_SEQUENTIAL)
+            logicData->willExplode = (struct KAWillExplode){tilePos.x,tilePos.y,true};
+        pushAtomStack(tilePos);
     }
     else
     {
@@ -161,47 +590,222 @@ static void prepareNewAtoms(int x, int y)
     }
 }
 
-/// @brief Check for animations, move atoms, decrease explosion timers and calculate player atom counts
+#ifndef NDEBUG
+// Debug builds only: verify the player atom counts kept up to date by the board helpers against a full recount
+static void checkPlayerAtoms(void)
+{
+    const struct KABoard* board = &logicData->board;
+    int playerAtoms[4] = {0,0,0,0};
+    for(int i=0; i<board->gridWidth*board->gridHeight; i++)
+    {
+        if(board->owner[i] != NOOWNER)
+            playerAtoms[board->owner[i]] += board->count[i];
+    }
+    for(int i=0; i<4; i++)
+    {
+        if(playerAtoms[i] != board->playerAtoms[i])
+            gamelogic_errorMsg("Game: Player %d atom count is %d, but the board has %d atoms of that player!",i+1,board->playerAtoms[i],playerAtoms[i]);
+    }
+}
+#endif
+
+/// @brief Move atoms and decrease explosion timers of animating tiles, removing the tiles which finished their animations from the list
 /// @param dt DeltaTime from update state callback, used for atom movement speed calculation
 static void doTileActions(float dt)
 {
     logicData->animPlaying = false;
-    memset(logicData->playerAtoms, 0, sizeof(logicData->playerAtoms));
     float explosionSpeedMultiplier = SDL_min(logicData->explosionCount,1000)/10.0f;
     float atomMoveSpeed = baseAtomSpeed*dt*SDL_max(explosionSpeedMultiplier, 1);
-    for(int x=0; x<logicData->gridWidth; x++)
+    struct KABoard* board = &logicData->board;
+    for(int i=0; i<logicData->animTileCount;)
     {
-        for(int y=0; y<logicData->gridHeight; y++)
+        int index = logicData->animTiles[i];
+        struct KATile* curTile = &logicData->tiles[index];
+        bool finished = true;
+        if(curTile->explodeTime > 0)
+        {
+            curTile->explodeTime -= dt;
+            if(curTile->explodeTime <= 0)
+                curTile->explodeTime = 0.0f;
+            else
+                logicData->animPlaying = true;
+            //Atoms on the tile can only move after the explosion disappears, so check them next time
+            finished = false;
+        }
+        else if(board->owner[index] != NOOWNER)
         {
-            struct KATile* curTile = &logicData->tiles[x][y];
-            if(curTile->explodeTime > 0)
+            //Move animated atoms
+            int visibleAtomCount = SDL_min(board->count[index],MAX_VISIBLE_ATOMS);
+            for(int j=0; j<visibleAtomCount; j++)
             {
-                curTile->explodeTime -= dt;
-                if(curTile->explodeTime <= 0)
-                    curTile->explodeTime = 0.0f;
-                else
+                struct KAAtom* curAtom = &curTile->atoms[j];
+                //If the atom isn't at its target position, move it
+                if((curAtom->curx != curAtom->endx) || (curAtom->cury != curAtom->endy))
+                {
                     logicData->animPlaying = true;
+                    finished = false;
+                    float xmove = SDL_clamp(curAtom->endx-curAtom->curx,-atomMoveSpeed,atomMoveSpeed);
+                    float ymove = SDL_clamp(curAtom->endy-curAtom->cury,-atomMoveSpeed,atomMoveSpeed);
+                    curAtom->curx += xmove;
+                    curAtom->cury += ymove;
+                }
             }
-            else if(curTile->playerNum >= 0)
+        }
+
+        if(finished)
+        {
+            curTile->animating = false;
+            logicData->animTiles[i] = logicData->animTiles[--logicData->animTileCount];
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+bool gamelogic_allocBoard(struct KABoard* board, int gridWidth, int gridHeight)
+{
+    memset(board, 0, sizeof(struct KABoard));
+    if(gridWidth < 1 || gridWidth > MAX_GRID_WIDTH || gridHeight < 1 || gridHeight > MAX_GRID_HEIGHT)
+        return false;
+
+    // Both tile arrays share a single allocation (the wider count array goes first to keep it aligned)
+    int tileCount = gridWidth*gridHeight;
+    board->count = malloc(tileCount*(sizeof(uint32_t)+sizeof(uint8_t)));
+    if(!board->count)
+        return false;
+    board->owner = (uint8_t*)(board->count+tileCount);
+    board->gridWidth = gridWidth;
+    board->gridHeight = gridHeight;
+    memset(board->owner, NOOWNER, tileCount);
+    memset(board->count, 0, tileCount*sizeof(uint32_t));
+    return true;
+}
+
+void gamelogic_copyBoard(struct KABoard* dst, const struct KABoard* src)
+{
+    int tileCount = src->gridWidth*src->gridHeight;
+    memcpy(dst->playerAtoms, src->playerAtoms, sizeof(dst->playerAtoms));
+    dst->explosionMode = src->explosionMode;
+    dst->hash = src->hash;
+    memcpy(dst->owner, src->owner, tileCount);
+    memcpy(dst->count, src->count, tileCount*sizeof(uint32_t));
+}
+
+void gamelogic_freeBoard(struct KABoard* board)
+{
+    free(board->count);
+    board->owner = NULL;
+    board->count = NULL;
+}
+
+bool gamelogic_getBoard(struct KABoard* board)
+{
+    if(!gamelogic_allocBoard(board, logicData->board.gridWidth, logicData->board.gridHeight))
+        return false;
+    gamelogic_copyBoard(board, &logicData->board);
+    return true;
+}
+
+int gamelogic_resolveMove(struct KABoard* board, const enum PlayerStatus playerStatus[4], int x, int y, int player)
+{
+    if(x < 0 || x >= board->gridWidth || y < 0 || y >= board->gridHeight || player < 0 || player > 3)
+        return -1;
+    int index = BOARD_INDEX(board,x,y);
+    if(board->owner[index] != NOOWNER && board->owner[index] != player)
+        return -1;
+
+    if(board->explosionMode == EXPLOSION_WAVE)
+    {
+        // Use the bitboard kernel when the board fits in it, otherwise (or if a tile gets too many atoms for it) resolve the waves on the board arrays
+        struct KABitboardMasks masks;
+        struct KABitboard bitboard;
+        if(gamebitboard_initMasks(&masks,board->gridWidth,board->gridHeight) && gamebitboard_fromBoard(&bitboard,board,&masks))
+        {
+            // Owning every atom only wins once every other remaining player has placed atoms
+            bool canWin = true;
+            for(int i=0; i<4; i++)
             {
-                logicData->playerAtoms[curTile->playerNum] += curTile->atomCount;
-                //Move animated atoms
-                for(int i=0; i<curTile->atomCount; i++)
-                {
-                    struct KAAtom* curAtom = &curTile->atoms[i];
-                    //If the atom isn't at its target position, move it
-                    if((curAtom->curx != curAtom->endx) || (curAtom->cury != curAtom->endy))
-                    {
-                        logicData->animPlaying = true;
-                        float xmove = SDL_clamp(curAtom->endx-curAtom->curx,-atomMoveSpeed,atomMoveSpeed);
-                        float ymove = SDL_clamp(curAtom->endy-curAtom->cury,-atomMoveSpeed,atomMoveSpeed);
-                        curAtom->curx += xmove;
-                        curAtom->cury += ymove;
-                    }
-                }
+                if(i != player && playerStatus[i] == PST_NOTSTARTED)
+                    canWin = false;
+            }
+            int explosionCount = gamebitboard_resolveMove(&bitboard,x,y,player,canWin);
+            if(explosionCount >= 0)
+            {
+                gamebitboard_toBoard(&bitboard,board);
+                return explosionCount;
+            }
+        }
+        boardPutAtoms(board,index,player,1);
+        return boardResolveWaves(board,playerStatus,player);
+    }
+
+    boardPutAtoms(board,index,player,1);
+    if((int)board->count[index] < boardGetCrit(board,x,y))
+        return 0;
+
+    // Same order of explosions as in gamelogic_tick, but without the per-tick stack pop limit
+    struct ResolveStack stack;
+    stack.items = stack.localItems;
+    stack.count = 0;
+    stack.capacity = RESOLVESTACKSIZE;
+    int explosionCount = 0;
+    resolveStackPush(&stack,index);
+    boardExplode(board,x,y);
+    explosionCount++;
+    while(stack.count > 0)
+    {
+        // The player has won, so the chain reaction can't change the result anymore (like checkEarlyWin in the game)
+        if(boardIsWinning(board,playerStatus,player))
+            break;
+
+        int nindex = boardCheckSurrounding(board,stack.items[stack.count-1]);
+        if(nindex >= 0)
+        {
+            if(!resolveStackPush(&stack,nindex))
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_ERROR,"resolveMove: couldn't allocate chain reaction stack");
+                break;
             }
+            boardExplode(board,nindex % board->gridWidth,nindex / board->gridWidth);
+            explosionCount++;
         }
+        else
+        {
+            stack.count--;
+        }
+    }
+    resolveStackFree(&stack);
+    return explosionCount;
+}
+
+bool gamelogic_updatePlayerStatus(const struct KABoard* board, enum PlayerStatus playerStatus[4], int player)
+{
+    // Players who didn't place any atoms yet can't lose
+    playerStatus[player] = PST_PLAYING;
+    bool playerWon = true;
+    for(int i=0; i<4; i++)
+    {
+        if(i == player)
+            continue;
+        if(playerStatus[i] == PST_PLAYING && board->playerAtoms[i] <= 0)
+            playerStatus[i] = PST_LOST;
+        if(playerStatus[i] > PST_LOST)
+            playerWon = false;
+    }
+    return playerWon;
+}
+
+int gamelogic_getNextPlayer(const enum PlayerStatus playerStatus[4], int player)
+{
+    for(int i=1; i<=4; i++)
+    {
+        int nextPlayer = (player+i) & 3;
+        if(playerStatus[nextPlayer] > PST_LOST)
+            return nextPlayer;
     }
+    return player;
 }
 
 void gamelogic_setAtoms(int x, int y, int player, uint32_t atomCount)
@@ -211,15 +815,19 @@ void gamelogic_setAtoms(int x, int y, int player, uint32_t atomCount)
         SDL_LogError(SDL_LOG_CATEGORY_ERROR,"setAtoms: invalid position (%d, %d)",x,y);
         return;
     }
+    if(atomCount > INT32_MAX)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"setAtoms: invalid atom count (%u)",(unsigned)atomCount);
+        return;
+    }
 
-    struct KATile* curTile = &logicData->tiles[x][y];
+    struct KATile* curTile = &logicData->tiles[BOARD_INDEX(&logicData->board,x,y)];
     curTile->explodeTime = 0;
-    curTile->atomCount = atomCount;
-    curTile->playerNum = player;
+    boardSetAtoms(&logicData->board, BOARD_INDEX(&logicData->board,x,y), player, (int)atomCount);
+    ai_TileChanged(x, y);
     switch(atomCount)
     {
         case 0:
-            curTile->playerNum = NOPLAYER;
             break;
         case 1:
             curTile->atoms[0] = (struct KAAtom){atomMidPos,atomMidPos,atomMidPos,atomMidPos};
@@ -243,8 +851,8 @@ void gamelogic_setAtoms(int x, int y, int player, uint32_t atomCount)
     int visibleAtomCount = SDL_min(atomCount,MAX_VISIBLE_ATOMS);
     for(int i=4; i<visibleAtomCount; i++)
     {
-        int ax = (rand() % 11)+5;
-        int ay = (rand() % 11)+5;
+        int ax = krandom_range(&logicData->random,11)+5;
+        int ay = krandom_range(&logicData->random,11)+5;
         curTile->atoms[i] = (struct KAAtom){ax,ay,ax,ay};
     }
 }
@@ -262,7 +870,6 @@ void gamelogic_setPlayers(int (*_playerTypes)[4])
             
             logicData->curPlayerCount++;
             logicData->playerStatus[i] = PST_NOTSTARTED;
-            logicData->playerAtoms[i] = 0;
             if(playerTypes[i] > 1)
             {
                 aiPlayer[i] = true;
@@ -281,60 +888,104 @@ void gamelogic_setPlayers(int (*_playerTypes)[4])
     logicData->totalPlayerCount = logicData->curPlayerCount;
 }
 
-void gamelogic_init(int gridWidth, int gridHeight, int (*playerTypes)[4])
+// Frees the grid storage allocated by gamelogic_setGridSize
+static void freeGrid(void)
 {
-    if(logicData)
-        gamelogic_stop();
+    gamelogic_freeBoard(&logicData->board);
+    free(logicData->tiles);
+    free(logicData->critGrid);
+    free(logicData->animTiles);
+    free(logicData->atomStack);
+    free(logicData->waveCounts);
+    logicData->tiles = NULL;
+    logicData->critGrid = NULL;
+    logicData->animTiles = NULL;
+    logicData->atomStack = NULL;
+    logicData->waveCounts = NULL;
+}
 
-    if(gridWidth*gridHeight > MAX_GRID_WIDTH*MAX_GRID_HEIGHT)
+bool gamelogic_setGridSize(int gridWidth, int gridHeight)
+{
+    if(gridWidth < 1 || gridWidth > MAX_GRID_WIDTH || gridHeight < 1 || gridHeight > MAX_GRID_HEIGHT)
     {
-        game_errorMsg("Game: Grid size is above maximum! (%d > %d)",gridWidth*gridHeight,MAX_GRID_WIDTH*MAX_GRID_HEIGHT);
-        return;
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"setGridSize: invalid grid size (%d x %d), max is %d x %d",gridWidth,gridHeight,MAX_GRID_WIDTH,MAX_GRID_HEIGHT);
+        return false;
     }
-    logicData = calloc(1,sizeof(struct GameLogicData));
+
+    enum ExplosionMode explosionMode = logicData->board.explosionMode;
+    freeGrid();
+    int tileCount = gridWidth*gridHeight;
+    bool boardAllocated = gamelogic_allocBoard(&logicData->board, gridWidth, gridHeight);
+    logicData->tiles = calloc(tileCount, sizeof(struct KATile));
+    logicData->critGrid = malloc(tileCount*sizeof(int));
+    logicData->animTiles = malloc(tileCount*sizeof(int));
+    logicData->atomStack = malloc(tileCount*sizeof(Vec2));
+    logicData->waveCounts = malloc(tileCount*sizeof(uint32_t));
+    if(!boardAllocated || !logicData->tiles || !logicData->critGrid || !logicData->animTiles || !logicData->atomStack || !logicData->waveCounts)
+    {
+        gamelogic_errorMsg("Game: Couldn't allocate a %d x %d grid!",gridWidth,gridHeight);
+        return false;
+    }
+    logicData->board.explosionMode = explosionMode;
     logicData->gridWidth = gridWidth;
     logicData->gridHeight = gridHeight;
+    logicData->animTileCount = 0;
+    logicData->animPlaying = false;
+    logicData->atomStackSize = tileCount;
+    logicData->atomStackPos = 0;
+    logicData->willExplode.explode = false;
     for(int x=0; x<gridWidth; x++) //Grid setup
     {
         for(int y=0; y<gridHeight; y++)
         {
-            struct KATile* curTile = &logicData->tiles[x][y];
-            curTile->explodeTime = 0;
-            curTile->atomCount = 0;
-            curTile->playerNum = NOPLAYER;
-            logicData->critGrid[x][y] = 4;
+            int index = BOARD_INDEX(&logicData->board,x,y);
+            logicData->critGrid[index] = 4;
             if(x == 0 || x == gridWidth-1)
-                logicData->critGrid[x][y]--;
+                logicData->critGrid[index]--;
             if(y == 0 || y == gridHeight-1)
-                logicData->critGrid[x][y]--;
+                logicData->critGrid[index]--;
         }
     }
+    return true;
+}
+
+void gamelogic_init(int gridWidth, int gridHeight, int (*playerTypes)[4], enum ExplosionMode explosionMode, uint64_t seed)
+{
+    if(logicData)
+        gamelogic_stop();
+
+    if(gridWidth < 1 || gridWidth > MAX_GRID_WIDTH || gridHeight < 1 || gridHeight > MAX_GRID_HEIGHT)
+    {
+        gamelogic_errorMsg("Game: Grid size is invalid! (%d x %d), max is %d x %d",gridWidth,gridHeight,MAX_GRID_WIDTH,MAX_GRID_HEIGHT);
+        return;
+    }
+    logicData = calloc(1,sizeof(struct GameLogicData));
+    krandom_seed(&logicData->random, seed);
+    logicData->board.explosionMode = explosionMode;
+    if(!gamelogic_setGridSize(gridWidth, gridHeight))
+        return;
     logicData->animPlaying = false;
     logicData->curPlayer = NOPLAYER;
     logicData->curPlayerCount = 0;
     memset(aiPlayer, 0, sizeof(aiPlayer));
     memset(aiDifficulty, 0, sizeof(aiDifficulty));
-    ai_Init();
     gamelogic_setPlayers(playerTypes);
-    logicData->atomStackPos = 0;
+    ai_Init();
     logicData->playerWon = NOPLAYER;
     logicData->explosionCount = 0;
     if(logicData->curPlayer == NOPLAYER || logicData->totalPlayerCount < 2)
-        game_printMsg("2 or more players required to play!",3);
+        printMsg("2 or more players required to play!",3);
 }
 
 void gamelogic_tick(float dt)
 {
-    if(logicData->explosionCount >= ATOMSTACKSIZE)
-    {
-        game_printMsg("More than "XSTR(ATOMSTACKSIZE)" simultaneous explosions! Stopping...",4);
-        changeState(ST_MENUSTATE);
-        return;
-    }
     doTileActions(dt);
+    #ifndef NDEBUG
+    checkPlayerAtoms();
+    #endif
     for(int i=0; i<4; i++)
     {
-        if(logicData->playerStatus[i] == PST_PLAYING && logicData->playerAtoms[i] <= 0)
+        if(logicData->playerStatus[i] == PST_PLAYING && logicData->board.playerAtoms[i] <= 0)
         {
             logicData->curPlayerCount--;
             logicData->playerStatus[i] = PST_LOST;
@@ -359,10 +1010,21 @@ void gamelogic_tick(float dt)
     }
     if(!logicData->animPlaying)
     {
-        if(logicData->willExplode.explode)
+        if(logicData->board.explosionMode == EXPLOSION_WAVE && logicData->atomStackPos > 0)
+        {
+            explodeWave();
+            if(checkEarlyWin())
+                return;
+            if(logicData->atomStackPos == 0)
+                nextPlayer();
+        }
+        else if(logicData->willExplode.explode)
         {
             explodeAtoms(logicData->willExplode.x, logicData->willExplode.y);
             logicData->willExplode.explode = false;
+            // The rest of the chain reaction can't change the result if the game is already won
+            if(checkEarlyWin())
+                return;
         }
         else if(logicData->atomStackPos > 0)
         {
@@ -370,11 +1032,12 @@ void gamelogic_tick(float dt)
             for(int i=0; i<maxStackPops; i++)
             {
                 Vec2* curPos = &logicData->atomStack[logicData->atomStackPos-1];
-                Vec2 pmoveTab = checkSurrounding(curPos->x, curPos->y);
-                if(pmoveTab.x != INT_MAX)
+                int critIndex = boardCheckSurrounding(&logicData->board, BOARD_INDEX(&logicData->board,curPos->x,curPos->y));
+                if(critIndex >= 0)
                 {
+                    Vec2 pmoveTab = {critIndex % logicData->gridWidth, critIndex / logicData->gridWidth};
                     logicData->willExplode = (struct KAWillExplode){pmoveTab.x, pmoveTab.y, true};
-                    logicData->atomStack[logicData->atomStackPos++] = pmoveTab;
+                    pushAtomStack(pmoveTab);
                     break;
                 }
                 else
@@ -390,15 +1053,19 @@ void gamelogic_tick(float dt)
         }
         else if(aiPlayer[logicData->curPlayer])
         {
-            ai_TryMove();
+            ai_TryMove(&logicData->random);
+        }
+        else
+        {
+            ai_Ponder(&logicData->random);
         }
     }
 }
 
 void gamelogic_clickedTile(int x, int y, bool isAIMove)
 {
-    int tilePlayer = logicData->tiles[x][y].playerNum;
-    if(tilePlayer >= 0 && tilePlayer != logicData->curPlayer)
+    int tilePlayer = logicData->board.owner[BOARD_INDEX(&logicData->board,x,y)];
+    if(tilePlayer != NOOWNER && tilePlayer != logicData->curPlayer)
         return;
     if(!isAIMove && aiPlayer[logicData->curPlayer])
         return;
@@ -406,12 +1073,35 @@ void gamelogic_clickedTile(int x, int y, bool isAIMove)
         return;
     logicData->explosionCount = 0;
     logicData->playerStatus[logicData->curPlayer] = PST_PLAYING;
-    wavplayer_play(sfxPut);
+    ai_MoveMade(x,y);
+    sendEvent(GEV_ATOMPUT, 1);
     prepareNewAtoms(x,y);
 }
 
+void gamelogic_setPresenter(const struct GamePresenter* newPresenter)
+{
+    presenter = newPresenter;
+}
+
+void gamelogic_errorMsg(const char* format, ...)
+{
+    char errorBuffer[256];
+    va_list args;
+    va_start(args,format);
+    vsnprintf(errorBuffer, sizeof(errorBuffer), format, args);
+    va_end(args);
+
+    if(presenter && presenter->errorMsg)
+        presenter->errorMsg(errorBuffer);
+    else
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"%s",errorBuffer);
+}
+
 void gamelogic_stop(void)
 {
+    ai_Cancel();
+    if(logicData)
+        freeGrid();
     free(logicData);
     logicData = NULL;
 }
@@ -1,17 +1,32 @@
 #pragma once
 #include <stdbool.h>
 #include <stdint.h>
+#include "../../utils/random.h"
 
-// Size of the atom stack / explosion count limit
-#define ATOMSTACKSIZE 5000
 // Limit of visible atoms per tile
 #define MAX_VISIBLE_ATOMS 8
 #define NOPLAYER -1
 
-// Max supported grid width
-#define MAX_GRID_WIDTH 13
-// Max supported grid height
-#define MAX_GRID_HEIGHT 8
+// Max grid width supported by the game logic (the menu has its own limit, MAX_GRIDWIDTH in game.h)
+#define MAX_GRID_WIDTH 256
+// Max grid height supported by the game logic (the menu has its own limit, MAX_GRIDHEIGHT in game.h)
+#define MAX_GRID_HEIGHT 256
+
+// Owner value of a tile without atoms in KABoard
+#define NOOWNER 0xFF
+
+// Index of a tile at a given position in KABoard arrays
+#define BOARD_INDEX(board,x,y) ((y)*(board)->gridWidth+(x))
+
+// Tiles with more atoms than this share a Zobrist key (tiles that aren't exploding never have more than 3 atoms)
+#define ZOBRIST_MAX_COUNT 7
+
+// Chain reaction propagation mode
+enum ExplosionMode
+{
+    EXPLOSION_SEQUENTIAL,   //Critical tiles explode one at a time in depth-first order (original rules)
+    EXPLOSION_WAVE          //Every critical tile explodes at the same time, one wave per step
+};
 
 enum PlayerStatus
 {
@@ -40,11 +55,11 @@ struct KAAtom {
     float endy;     //Destination atom Y position (relative to tile it's on)
 };
 
+// Animation data of a tile, the tile player and atom count are stored in GameLogicData.board
 struct KATile {
-    int playerNum;                              //Tile player number (equal to NOPLAYER if no player has atoms on that tile)
     struct KAAtom atoms[MAX_VISIBLE_ATOMS];     //Array of atom positions and destination positions (limited to MAX_VISIBLE_ATOMS)
-    int atomCount;                              //Amount of atoms in a tile
     float explodeTime;                          //Time left until explosion disappears
+    bool animating;                             //Is the tile in the GameLogicData.animTiles list
 };
 
 struct KAWillExplode {
@@ -53,27 +68,124 @@ struct KAWillExplode {
     bool explode;   //Will a tile explode? If false, other values are irrelevant
 };
 
+// Compact rules-only board state without any animation data, tiles are indexed as [y*gridWidth+x]
+// The tile arrays are allocated by gamelogic_allocBoard and freed by gamelogic_freeBoard
+struct KABoard {
+    int gridWidth;                      //Board width in tiles
+    int gridHeight;                     //Board height in tiles
+    int playerAtoms[4];                 //Atom count of every player on the board
+    enum ExplosionMode explosionMode;   //How chain reactions are resolved on this board
+    uint8_t* owner;                     //Tile player number (NOOWNER if the tile is empty)
+    uint32_t* count;                    //Amount of atoms in a tile
+    uint64_t hash;                      //Zobrist key of the tiles (XOR of gamelogic_getTileKey of every tile), updated by every board change
+};
+
 struct GameLogicData {
-    struct KATile tiles[MAX_GRID_WIDTH][MAX_GRID_HEIGHT];   //Struct of tile data indexed as [x][y]
-    int critGrid[MAX_GRID_WIDTH][MAX_GRID_HEIGHT];          //Struct of critical atom amounts per tile
+    struct KABoard board;                                   //Rules state of the grid (tile players, atom counts and player atom counts)
+    struct KATile* tiles;                                   //Array of tile animation data indexed like the board tiles
+    int* critGrid;                                          //Array of critical atom amounts per tile indexed like the board tiles
     int gridWidth;                                          //Current grid width in tiles
     int gridHeight;                                         //Current grid height in tiles
-    bool animPlaying;                                       //TRUE if animation is playing
+    bool animPlaying;                                       //TRUE if animation is playing (animTiles is not empty)
+    int* animTiles;                                         //Board indices of tiles with atom movement or explosion animations in progress
+    int animTileCount;                                      //Amount of tiles in animTiles
     int curPlayer;                                          //Currently playing player number
     enum PlayerStatus playerStatus[4];                      //Player statuses (PlayerStatus enums)
-    int playerAtoms[4];                                     //Player atom count
     int curPlayerCount;                                     //Current player count (not counting players who lost)
     int totalPlayerCount;                                   //Total player count (counting players who lost)
     int explosionCount;                                     //Current explosion count (restarts every new turn)
     int playerWon;                                          //Player number that won the game (NOPLAYER if the game has not ended)
     struct KAWillExplode willExplode;                       //Struct holding tile that will explode soon (if willExplode.explode == true)
-    Vec2 atomStack[ATOMSTACKSIZE];                          //Atom stack, used to store previous explosion positions for chain reactions
+    Vec2* atomStack;                                        //Atom stack, used to store previous explosion positions for chain reactions (tiles of the next wave in EXPLOSION_WAVE mode, grows when full)
     int atomStackPos;                                       //Current atom stack position
+    int atomStackSize;                                      //Amount of allocated atom stack entries
+    uint32_t* waveCounts;                                   //Tile atom counts before the current explosion wave (EXPLOSION_WAVE animations), indexed like the board tiles
+    KRandom random;                                         //Random number generator used by atom animations and AI players
+};
+
+// Game events the presentation layer can react to
+enum GameEvent
+{
+    GEV_ATOMPUT,    //A player made a move (tileCount is 1)
+    GEV_EXPLOSION   //Critical tiles blew up, a single tile in EXPLOSION_SEQUENTIAL mode or a whole wave in EXPLOSION_WAVE mode (tileCount is the amount of tiles)
+};
+
+// Presentation callbacks of the game logic and the AI, every callback can be NULL (headless programs don't need a window or audio)
+struct GamePresenter {
+    void (*printMsg)(const char* str, float time);          //Show an info message for a given time in seconds (NULL = log it)
+    void (*errorMsg)(const char* str);                      //Report an error the game can't continue after (NULL = log it)
+    void (*gameEvent)(enum GameEvent event, int tileCount); //Called for every move and explosion (NULL = ignore them)
 };
 
 // The main game data
 extern struct GameLogicData* logicData;
 
+/// @brief Set the presentation callbacks used by the following games
+/// @param presenter Presentation callbacks (NULL = log messages and errors only), has to stay valid while a game is running
+void gamelogic_setPresenter(const struct GamePresenter* presenter);
+
+/// @brief Report an error the game can't continue after through the presenter
+/// @param format printf format string
+void gamelogic_errorMsg(const char* format, ...);
+
+/// @brief Allocate an empty compact board
+/// @param board Board to initialize
+/// @param gridWidth Board width (1-MAX_GRID_WIDTH)
+/// @param gridHeight Board height (1-MAX_GRID_HEIGHT)
+/// @return true on success, false if the size is invalid or the allocation failed
+bool gamelogic_allocBoard(struct KABoard* board, int gridWidth, int gridHeight);
+
+/// @brief Copy a compact board to another one without allocating memory
+/// @param dst Destination board, has to be allocated with the same size as src
+/// @param src Source board
+void gamelogic_copyBoard(struct KABoard* dst, const struct KABoard* src);
+
+/// @brief Free the tile arrays of a board allocated by gamelogic_allocBoard
+/// @param board Board to free
+void gamelogic_freeBoard(struct KABoard* board);
+
+/// @brief Copy the current rules state (tile players and atom counts) to a new compact board
+/// @param board Board to allocate and write the state to, has to be freed with gamelogic_freeBoard
+/// @return true on success, false if the board couldn't be allocated
+bool gamelogic_getBoard(struct KABoard* board);
+
+/// @brief Place an atom on a compact board and resolve the entire chain reaction instantly (without animations)
+/// The chain reaction stops early only when the game would end, with the same win condition as the game.
+/// @param board Board to modify, it contains the final state after the move
+/// @param playerStatus Player statuses before the move
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @param player Player making the move
+/// @return Amount of explosions caused by the move or -1 if the move is invalid
+int gamelogic_resolveMove(struct KABoard* board, const enum PlayerStatus playerStatus[4], int x, int y, int player);
+
+/// @brief Get the Zobrist key of a single tile, keys of different tile states never collide
+/// @param index Tile index
+/// @param owner Tile player (NOOWNER for an empty tile)
+/// @param count Tile atom count (clamped to ZOBRIST_MAX_COUNT)
+/// @return Tile key (0 for an empty tile)
+uint64_t gamelogic_getTileKey(int index, int owner, int count);
+
+/// @brief Get the Zobrist key of a position: the board tiles, the player to move, the players who didn't place any atoms yet, the grid size and the explosion mode
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @param player Player to move
+/// @return Position key
+uint64_t gamelogic_getPositionKey(const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player);
+
+/// @brief Update player statuses after a move on a compact board with the same elimination rules as the game (used by AI simulations)
+/// @param board Board after the move
+/// @param playerStatus Player statuses to update
+/// @param player Player that made the move
+/// @return true if the player has won the game with that move
+bool gamelogic_updatePlayerStatus(const struct KABoard* board, enum PlayerStatus playerStatus[4], int player);
+
+/// @brief Get the next player that's still in the game
+/// @param playerStatus Player statuses
+/// @param player Current player
+/// @return Next player number (equal to player if nobody else is left)
+int gamelogic_getNextPlayer(const enum PlayerStatus playerStatus[4], int player);
+
 /// @brief Set atoms on a tile without animations
 /// @param x Tile X position
 /// @param y Tile Y position
@@ -89,7 +201,15 @@ void gamelogic_setPlayers(int (*playerTypes)[4]);
 /// @param gridWidth Grid width
 /// @param gridHeight Grid height
 /// @param playerTypes Pointer to player type array (corresponding to player type settings)
-void gamelogic_init(int gridWidth, int gridHeight, int (*playerTypes)[4]);
+/// @param explosionMode Chain reaction propagation mode
+/// @param seed Random number generator seed, the same seed and moves always give the same game
+void gamelogic_init(int gridWidth, int gridHeight, int (*playerTypes)[4], enum ExplosionMode explosionMode, uint64_t seed);
+
+/// @brief Reallocates the grid for a new size and clears every tile (used when loading a saved game)
+/// @param gridWidth New grid width (1-MAX_GRID_WIDTH)
+/// @param gridHeight New grid height (1-MAX_GRID_HEIGHT)
+/// @return true on success, false if the size is invalid
+bool gamelogic_setGridSize(int gridWidth, int gridHeight);
 
 /// @brief Runs a game tick
 /// @param dt Delta time from update state callback
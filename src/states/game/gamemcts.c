@@ -0,0 +1,565 @@
+#include "gamemcts.h"
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Amount of tree nodes allocated at the start of the search (the node array doubles in size when it's full)
+#define MCTS_INITIAL_NODES 1024
+
+// Search tree node, every node except the root is the position after a single move
+struct MCTSNode {
+    int firstChild;     //Index of the first child node or -1
+    int nextSibling;    //Index of the next child node of the same parent or -1
+    int move;           //Tile index of the move leading to this node
+    int expandedMoves;  //Amount of legal moves in this position that already have a child node
+    int visits;         //Amount of playouts that went through this node
+    float reward[4];    //Summed playout rewards of every player
+    int8_t player;      //Player that made the move leading to this node
+};
+
+// Playout state of a single search thread
+struct MCTSWorker {
+    struct KABoard board;       //Board used by the current playout
+    enum PlayerStatus status[4];//Player statuses used by the current playout
+    int* moves;                 //Move list (tileCount entries)
+    int* path;                  //Nodes visited by the current playout (MCTS_MAX_NODES entries)
+    KRandom* random;            //Random number generator used by the playouts
+    KRandom ownRandom;          //Generator of extra pool threads, seeded from the search generator
+};
+
+// Search tree shared by every search thread
+struct MCTSTree {
+    int tileCount;              //Amount of tiles on the board
+    struct KABoard rootBoard;   //Board of the root position
+    enum PlayerStatus rootStatus[4];//Player statuses of the root position
+    int rootPlayer;             //Player to move in the root position
+    SDL_SpinLock lock;          //Protects the nodes while searching with a thread pool
+    struct MCTSNode* nodes;     //Tree nodes (nodes[0] is the root)
+    int nodeCount;
+    int nodeCapacity;
+    struct MCTSWorker* workers[KTHREADPOOL_MAX_THREADS];   //Playout state of every search thread, allocated when first needed
+};
+
+// Search budget shared by the search threads
+struct MCTSSearch {
+    struct MCTSTree* tree;
+    const struct AIMCTSParams* params;
+    Uint64 startTime;
+    SDL_atomic_t playouts;      //Amount of playouts started
+};
+
+/// @brief Get the critical atom amount of a board tile
+/// @param board Compact board
+/// @param index Tile index
+/// @return Critical atom amount (2 for corners, 3 for sides, 4 otherwise)
+static int mctsGetCrit(const struct KABoard* board, int index)
+{
+    int x = index % board->gridWidth;
+    int y = index / board->gridWidth;
+    return 4 - (x == 0 || x == board->gridWidth-1) - (y == 0 || y == board->gridHeight-1);
+}
+
+/// @brief Check if a tile is next to an enemy tile that's about to explode
+/// @param board Compact board
+/// @param index Tile index
+/// @param player Player owning the tile
+/// @return true if the tile is threatened
+static bool mctsIsThreatened(const struct KABoard* board, int index, int player)
+{
+    int x = index % board->gridWidth;
+    int y = index / board->gridWidth;
+    int nearbyTiles[4];
+    int nearbyTileCount = 0;
+    if(y > 0)
+        nearbyTiles[nearbyTileCount++] = index-board->gridWidth;
+    if(y < board->gridHeight-1)
+        nearbyTiles[nearbyTileCount++] = index+board->gridWidth;
+    if(x > 0)
+        nearbyTiles[nearbyTileCount++] = index-1;
+    if(x < board->gridWidth-1)
+        nearbyTiles[nearbyTileCount++] = index+1;
+    for(int i=0; i<nearbyTileCount; i++)
+    {
+        int nindex = nearbyTiles[i];
+        if(board->owner[nindex] != NOOWNER && board->owner[nindex] != player && (int)board->count[nindex] == mctsGetCrit(board,nindex)-1)
+            return true;
+    }
+    return false;
+}
+
+/// @brief List the legal moves of a player: tiles that explode right away first, then tiles that aren't threatened by enemy explosions, then the rest
+/// @param board Compact board
+/// @param player Player making the move
+/// @param moves Array to write the tile indices to (needs space for every tile)
+/// @param explosiveCount Set to the amount of moves that explode right away
+/// @param safeCount Set to the amount of moves that explode right away or aren't threatened
+/// @return Amount of moves
+static int mctsListMoves(const struct KABoard* board, int player, int* moves, int* explosiveCount, int* safeCount)
+{
+    int tileCount = board->gridWidth*board->gridHeight;
+    int moveCount = 0;
+    for(int i=0; i<tileCount; i++)
+    {
+        if(board->owner[i] == player && (int)board->count[i] == mctsGetCrit(board,i)-1)
+            moves[moveCount++] = i;
+    }
+    *explosiveCount = moveCount;
+    int unsafeCount = 0;
+    for(int i=0; i<tileCount; i++)
+    {
+        if(board->owner[i] == NOOWNER || (board->owner[i] == player && (int)board->count[i] != mctsGetCrit(board,i)-1))
+        {
+            // Unsafe tiles are collected at the end of the array and moved after the safe ones afterwards
+            if(mctsIsThreatened(board, i, player))
+                moves[tileCount-1-unsafeCount++] = i;
+            else
+                moves[moveCount++] = i;
+        }
+    }
+    *safeCount = moveCount;
+    for(int i=0; i<unsafeCount; i++)
+        moves[moveCount++] = moves[tileCount-1-i];
+    return moveCount;
+}
+
+/// @brief Make a move on the playout board
+/// @param worker Playout state
+/// @param index Tile index of the move
+/// @param player Player making the move
+/// @return true if the player won the game with that move
+static bool mctsMakeMove(struct MCTSWorker* worker, int index, int player)
+{
+    gamelogic_resolveMove(&worker->board, worker->status, index % worker->board.gridWidth, index / worker->board.gridWidth, player);
+    return gamelogic_updatePlayerStatus(&worker->board, worker->status, player);
+}
+
+/// @brief Score an unfinished game by the atom share of every player still in the game
+/// @param worker Playout state
+/// @param reward Reward of every player (0-1)
+static void mctsScoreAtoms(const struct MCTSWorker* worker, float reward[4])
+{
+    int totalAtoms = 0;
+    for(int p=0; p<4; p++)
+    {
+        if(worker->status[p] > PST_LOST)
+            totalAtoms += worker->board.playerAtoms[p];
+    }
+    for(int p=0; p<4; p++)
+        reward[p] = (totalAtoms > 0 && worker->status[p] > PST_LOST) ? (float)worker->board.playerAtoms[p]/totalAtoms : 0.0f;
+}
+
+/// @brief Play random moves until someone wins or the move limit is reached. Moves that explode right away are picked half of the time, threatened tiles only when there's nothing else.
+/// @param worker Playout state
+/// @param player Player to move
+/// @param reward Reward of every player (0-1)
+static void mctsPlayout(struct MCTSWorker* worker, int player, float reward[4])
+{
+    for(int i=0; i<MCTS_MAX_PLAYOUT_MOVES; i++)
+    {
+        int explosiveCount, safeCount;
+        int moveCount = mctsListMoves(&worker->board, player, worker->moves, &explosiveCount, &safeCount);
+        if(moveCount == 0)
+            break;
+        int move;
+        if(explosiveCount > 0 && krandom_range(worker->random,2) == 0)
+            move = worker->moves[krandom_range(worker->random,explosiveCount)];
+        else if(safeCount > 0)
+            move = worker->moves[krandom_range(worker->random,safeCount)];
+        else
+            move = worker->moves[krandom_range(worker->random,moveCount)];
+        if(mctsMakeMove(worker, move, player))
+        {
+            memset(reward, 0, 4*sizeof(float));
+            reward[player] = 1.0f;
+            return;
+        }
+        player = gamelogic_getNextPlayer(worker->status, player);
+    }
+    mctsScoreAtoms(worker, reward);
+}
+
+/// @brief Add a child node, the node array grows until MCTS_MAX_NODES is reached
+/// @param tree Search tree
+/// @param parent Parent node index
+/// @param move Tile index of the move
+/// @param player Player making the move
+/// @return New node index or -1 if the tree is full
+static int mctsAddNode(struct MCTSTree* tree, int parent, int move, int player)
+{
+    if(tree->nodeCount >= tree->nodeCapacity)
+    {
+        int newCapacity = SDL_min(tree->nodeCapacity*2, MCTS_MAX_NODES);
+        struct MCTSNode* newNodes = (newCapacity > tree->nodeCapacity) ? realloc(tree->nodes, newCapacity*sizeof(struct MCTSNode)) : NULL;
+        if(!newNodes)
+            return -1;
+        tree->nodes = newNodes;
+        tree->nodeCapacity = newCapacity;
+    }
+    int index = tree->nodeCount++;
+    struct MCTSNode* node = &tree->nodes[index];
+    memset(node, 0, sizeof(struct MCTSNode));
+    node->firstChild = -1;
+    node->nextSibling = tree->nodes[parent].firstChild;
+    node->move = move;
+    node->player = player;
+    tree->nodes[parent].firstChild = index;
+    tree->nodes[parent].expandedMoves++;
+    return index;
+}
+
+/// @brief Pick the child with the highest UCT value
+/// @param tree Search tree
+/// @param parent Parent node index
+/// @param exploration UCT exploration constant
+/// @return Child node index
+static int mctsSelectChild(const struct MCTSTree* tree, int parent, float exploration)
+{
+    float logVisits = logf((float)tree->nodes[parent].visits);
+    int bestChild = tree->nodes[parent].firstChild;
+    float bestValue = -1.0f;
+    for(int i=bestChild; i!=-1; i=tree->nodes[i].nextSibling)
+    {
+        const struct MCTSNode* child = &tree->nodes[i];
+        float value = child->reward[child->player]/child->visits + exploration*sqrtf(logVisits/child->visits);
+        if(value > bestValue)
+        {
+            bestValue = value;
+            bestChild = i;
+        }
+    }
+    return bestChild;
+}
+
+/// @brief Run a single search iteration: select a path with UCT, add a node, play the game out and update the path nodes.
+/// Only the node updates are done with the tree locked, so several threads can run iterations on the same tree.
+/// @param tree Search tree
+/// @param worker Playout state of the calling thread
+/// @param exploration UCT exploration constant
+static void mctsIterate(struct MCTSTree* tree, struct MCTSWorker* worker, float exploration)
+{
+    gamelogic_copyBoard(&worker->board, &tree->rootBoard);
+    memcpy(worker->status, tree->rootStatus, sizeof(worker->status));
+    int player = tree->rootPlayer;
+    int node = 0;
+    int pathLength = 0;
+    worker->path[pathLength++] = node;
+
+    // Path nodes are visited before the playout is done, so other threads see them as lost for now and spread over other moves (virtual loss)
+    SDL_AtomicLock(&tree->lock);
+    tree->nodes[node].visits++;
+    SDL_AtomicUnlock(&tree->lock);
+
+    float reward[4];
+    while(true)
+    {
+        // Moves are always listed in the same order for a given position, so expandedMoves points to the next new move
+        int explosiveCount, safeCount;
+        int moveCount = mctsListMoves(&worker->board, player, worker->moves, &explosiveCount, &safeCount);
+        SDL_AtomicLock(&tree->lock);
+        int child = -1;
+        bool expanded = false;
+        if(tree->nodes[node].expandedMoves < moveCount)
+        {
+            child = mctsAddNode(tree, node, worker->moves[tree->nodes[node].expandedMoves], player);
+            expanded = (child != -1);
+        }
+        if(child == -1 && tree->nodes[node].firstChild != -1)
+            child = mctsSelectChild(tree, node, exploration);
+        int move = -1;
+        if(child != -1)
+        {
+            tree->nodes[child].visits++;
+            move = tree->nodes[child].move;
+        }
+        SDL_AtomicUnlock(&tree->lock);
+        if(child == -1)
+        {
+            mctsPlayout(worker, player, reward);
+            break;
+        }
+
+        node = child;
+        worker->path[pathLength++] = node;
+        if(mctsMakeMove(worker, move, player))
+        {
+            memset(reward, 0, sizeof(reward));
+            reward[player] = 1.0f;
+            break;
+        }
+        player = gamelogic_getNextPlayer(worker->status, player);
+        if(expanded)
+        {
+            mctsPlayout(worker, player, reward);
+            break;
+        }
+    }
+
+    SDL_AtomicLock(&tree->lock);
+    for(int i=0; i<pathLength; i++)
+    {
+        struct MCTSNode* pathNode = &tree->nodes[worker->path[i]];
+        for(int p=0; p<4; p++)
+            pathNode->reward[p] += reward[p];
+    }
+    SDL_AtomicUnlock(&tree->lock);
+}
+
+/// @brief Clear the tree, leaving only an unvisited root node
+/// @param tree Search tree
+static void mctsClearTree(struct MCTSTree* tree)
+{
+    memset(&tree->nodes[0], 0, sizeof(struct MCTSNode));
+    tree->nodes[0].firstChild = -1;
+    tree->nodes[0].nextSibling = -1;
+    tree->nodes[0].move = -1;
+    tree->nodes[0].player = NOPLAYER;
+    tree->nodeCount = 1;
+}
+
+/// @brief Make a child of the root the new root, every node outside of its subtree is removed
+/// @param tree Search tree
+/// @param newRoot Index of the new root node
+/// @return true on success, false on allocation failure (the tree is unchanged)
+static bool mctsMoveRoot(struct MCTSTree* tree, int newRoot)
+{
+    struct MCTSNode* nodes = malloc(tree->nodeCapacity*sizeof(struct MCTSNode));
+    int* oldIndices = malloc(tree->nodeCount*sizeof(int));
+    if(!nodes || !oldIndices)
+    {
+        free(nodes);
+        free(oldIndices);
+        return false;
+    }
+
+    // Breadth-first copy, children of a node get consecutive indices so every sibling link points to the next node
+    oldIndices[0] = newRoot;
+    int nodeCount = 1;
+    for(int i=0; i<nodeCount; i++)
+    {
+        const struct MCTSNode* oldNode = &tree->nodes[oldIndices[i]];
+        nodes[i] = *oldNode;
+        nodes[i].nextSibling = (i > 0 && oldNode->nextSibling != -1) ? i+1 : -1;
+        nodes[i].firstChild = (oldNode->firstChild != -1) ? nodeCount : -1;
+        for(int child=oldNode->firstChild; child!=-1; child=tree->nodes[child].nextSibling)
+            oldIndices[nodeCount++] = child;
+    }
+    free(tree->nodes);
+    free(oldIndices);
+    tree->nodes = nodes;
+    tree->nodeCount = nodeCount;
+    return true;
+}
+
+/// @brief Free the playout state of a search thread
+/// @param worker Playout state (can be NULL)
+static void mctsFreeWorker(struct MCTSWorker* worker)
+{
+    if(!worker)
+        return;
+    gamelogic_freeBoard(&worker->board);
+    free(worker->moves);
+    free(worker->path);
+    free(worker);
+}
+
+/// @brief Allocate the playout state of search threads that don't have one yet
+/// @param tree Search tree
+/// @param threadCount Amount of search threads
+/// @return true on success, false on allocation failure
+static bool mctsAllocWorkers(struct MCTSTree* tree, int threadCount)
+{
+    for(int i=0; i<threadCount; i++)
+    {
+        if(tree->workers[i])
+            continue;
+        struct MCTSWorker* worker = calloc(1,sizeof(struct MCTSWorker));
+        if(!worker)
+            return false;
+        worker->moves = malloc(tree->tileCount*sizeof(int));
+        worker->path = malloc(MCTS_MAX_NODES*sizeof(int));
+        if(!worker->moves || !worker->path || !gamelogic_allocBoard(&worker->board, tree->rootBoard.gridWidth, tree->rootBoard.gridHeight))
+        {
+            mctsFreeWorker(worker);
+            return false;
+        }
+        tree->workers[i] = worker;
+    }
+    return true;
+}
+
+struct MCTSTree* gamemcts_createTree(const struct KABoard* board, int player, const enum PlayerStatus playerStatus[4])
+{
+    struct MCTSTree* tree = calloc(1,sizeof(struct MCTSTree));
+    if(!tree)
+        return NULL;
+    tree->tileCount = board->gridWidth*board->gridHeight;
+    tree->nodeCapacity = MCTS_INITIAL_NODES;
+    tree->nodes = malloc(tree->nodeCapacity*sizeof(struct MCTSNode));
+    if(!tree->nodes || !gamelogic_allocBoard(&tree->rootBoard, board->gridWidth, board->gridHeight) || !mctsAllocWorkers(tree, 1))
+    {
+        gamemcts_freeTree(tree);
+        return NULL;
+    }
+    gamelogic_copyBoard(&tree->rootBoard, board);
+    memcpy(tree->rootStatus, playerStatus, sizeof(tree->rootStatus));
+    tree->rootPlayer = player;
+    mctsClearTree(tree);
+    return tree;
+}
+
+void gamemcts_freeTree(struct MCTSTree* tree)
+{
+    if(!tree)
+        return;
+    gamelogic_freeBoard(&tree->rootBoard);
+    free(tree->nodes);
+    for(int i=0; i<KTHREADPOOL_MAX_THREADS; i++)
+        mctsFreeWorker(tree->workers[i]);
+    free(tree);
+}
+
+/// @brief Check if the root board and statuses match a given position
+/// @param tree Search tree
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @return true if the positions are the same
+static bool mctsIsSamePosition(const struct MCTSTree* tree, const struct KABoard* board, const enum PlayerStatus playerStatus[4])
+{
+    return tree->rootBoard.hash == board->hash && memcmp(tree->rootBoard.owner, board->owner, tree->tileCount) == 0 && memcmp(tree->rootBoard.count, board->count, tree->tileCount*sizeof(uint32_t)) == 0
+        && memcmp(tree->rootStatus, playerStatus, sizeof(tree->rootStatus)) == 0;
+}
+
+bool gamemcts_playMove(struct MCTSTree* tree, int x, int y)
+{
+    int index = BOARD_INDEX(&tree->rootBoard,x,y);
+    int child = tree->nodes[0].firstChild;
+    while(child != -1 && tree->nodes[child].move != index)
+        child = tree->nodes[child].nextSibling;
+    bool kept = (child != -1 && mctsMoveRoot(tree, child));
+    if(!kept)
+        mctsClearTree(tree);
+
+    gamelogic_resolveMove(&tree->rootBoard, tree->rootStatus, x, y, tree->rootPlayer);
+    gamelogic_updatePlayerStatus(&tree->rootBoard, tree->rootStatus, tree->rootPlayer);
+    tree->rootPlayer = gamelogic_getNextPlayer(tree->rootStatus, tree->rootPlayer);
+    return kept;
+}
+
+bool gamemcts_setRoot(struct MCTSTree* tree, const struct KABoard* board, int player, const enum PlayerStatus playerStatus[4])
+{
+    if(player == tree->rootPlayer && mctsIsSamePosition(tree, board, playerStatus))
+        return tree->nodes[0].visits > 0;
+
+    mctsClearTree(tree);
+    gamelogic_copyBoard(&tree->rootBoard, board);
+    memcpy(tree->rootStatus, playerStatus, sizeof(tree->rootStatus));
+    tree->rootPlayer = player;
+    return false;
+}
+
+/// @brief Check if the search budget is used up
+/// @param search Search budget
+/// @return true if the search should stop
+static bool mctsIsSearchDone(struct MCTSSearch* search)
+{
+    const struct AIMCTSParams* params = search->params;
+    if(params->timeLimit > 0 && SDL_GetTicks64() - search->startTime >= (Uint64)params->timeLimit)
+        return true;
+    return params->cancel && SDL_AtomicGet(params->cancel);
+}
+
+/// @brief Run search iterations until the budget is used up
+/// @param data Search budget
+/// @param threadIndex Index of the thread running the task
+static void mctsSearchTask(void* data, int threadIndex)
+{
+    struct MCTSSearch* search = data;
+    struct MCTSWorker* worker = search->tree->workers[threadIndex];
+    int maxPlayouts = search->params->maxPlayouts;
+    // A single playout is made if there's neither a time nor a playout limit
+    if(search->params->timeLimit <= 0 && maxPlayouts <= 0)
+        maxPlayouts = 1;
+    while(!mctsIsSearchDone(search))
+    {
+        // Playouts are claimed before they're made so the playout limit is exact with any amount of threads
+        int playout = SDL_AtomicAdd(&search->playouts, 1);
+        if(maxPlayouts > 0 && playout >= maxPlayouts)
+        {
+            SDL_AtomicAdd(&search->playouts, -1);
+            break;
+        }
+        mctsIterate(search->tree, worker, search->params->exploration);
+    }
+}
+
+bool gamemcts_search(struct MCTSTree* tree, const struct AIMCTSParams* params, KRandom* random, struct AIMCTSResult* result)
+{
+    int threadCount = params->threadPool ? kthreadpool_getThreadCount(params->threadPool) : 1;
+    if(!mctsAllocWorkers(tree, threadCount))
+        return false;
+    tree->workers[0]->random = random;
+    for(int i=1; i<threadCount; i++)
+    {
+        uint64_t seed = (uint64_t)krandom_next(random) << 32;
+        seed |= krandom_next(random);
+        krandom_seed(&tree->workers[i]->ownRandom, seed);
+        tree->workers[i]->random = &tree->workers[i]->ownRandom;
+    }
+
+    int explosiveCount, safeCount;
+    int* moves = tree->workers[0]->moves;
+    int moveCount = mctsListMoves(&tree->rootBoard, tree->rootPlayer, moves, &explosiveCount, &safeCount);
+    if(moveCount == 0)
+        return false;
+    int firstMove = moves[0];
+
+    // With a single legal move there's nothing to search
+    struct MCTSSearch search = {tree, params, SDL_GetTicks64(), {0}};
+    long reusedPlayouts = tree->nodes[0].visits;
+    if(moveCount > 1)
+    {
+        for(int i=1; params->threadPool && i<threadCount; i++)
+        {
+            if(!kthreadpool_submit(params->threadPool, mctsSearchTask, &search))
+                break;
+        }
+        mctsSearchTask(&search, 0);
+        if(params->threadPool)
+            kthreadpool_wait(params->threadPool);
+    }
+    Uint64 elapsed = SDL_GetTicks64() - search.startTime;
+    long playouts = SDL_AtomicGet(&search.playouts);
+    int bestMove = firstMove;
+    int bestVisits = -1;
+    float winRate = 0.0f;
+    for(int i=tree->nodes[0].firstChild; i!=-1; i=tree->nodes[i].nextSibling)
+    {
+        const struct MCTSNode* child = &tree->nodes[i];
+        if(child->visits > bestVisits)
+        {
+            bestVisits = child->visits;
+            bestMove = child->move;
+            winRate = (child->visits > 0) ? child->reward[tree->rootPlayer]/child->visits : 0.0f;
+        }
+    }
+    int gridWidth = tree->rootBoard.gridWidth;
+    result->move = (Vec2){bestMove % gridWidth, bestMove / gridWidth};
+    result->winRate = winRate;
+    result->playouts = playouts;
+    result->reusedPlayouts = reusedPlayouts;
+    result->nodes = tree->nodeCount;
+    result->timeMillis = elapsed;
+    result->playoutsPerSecond = (elapsed > 0) ? (long)(playouts*1000/elapsed) : playouts*1000;
+    return true;
+}
+
+bool gamemcts_findMove(const struct KABoard* board, int player, const enum PlayerStatus playerStatus[4], const struct AIMCTSParams* params, KRandom* random, struct AIMCTSResult* result)
+{
+    struct MCTSTree* tree = gamemcts_createTree(board, player, playerStatus);
+    if(!tree)
+        return false;
+    bool found = gamemcts_search(tree, params, random, result);
+    gamemcts_freeTree(tree);
+    return found;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "gamelogic.h"
+#include "../../utils/random.h"
+#include "../../utils/threadpool.h"
+
+// Max amount of tree nodes, the tree stops growing (but playouts continue) once it's reached
+#define MCTS_MAX_NODES 65536
+
+// Max amount of moves in a single playout, unfinished playouts are scored by the atom share of every player
+#define MCTS_MAX_PLAYOUT_MOVES 12
+
+// Budget of the Monte Carlo tree search
+struct AIMCTSParams {
+    int timeLimit;      //Time budget in milliseconds (0 = no limit)
+    int maxPlayouts;    //Max amount of playouts, useful for reproducible runs (0 = no limit, a single playout is made if both limits are 0)
+    float exploration;  //UCT exploration constant
+    SDL_atomic_t* cancel;   //The search stops like on a time limit as soon as this is set to a non-zero value (can be NULL)
+    KThreadPool* threadPool;    //Thread pool running playouts on the shared tree (NULL = search on the calling thread only)
+};
+
+// Outcome of the Monte Carlo tree search
+struct AIMCTSResult {
+    Vec2 move;                  //Most visited move
+    float winRate;              //Average reward of the move for the searching player (0-1)
+    long playouts;              //Amount of finished playouts
+    long reusedPlayouts;        //Amount of playouts kept from earlier searches (see gamemcts_playMove)
+    int nodes;                  //Amount of tree nodes
+    uint64_t timeMillis;        //Time spent searching in milliseconds
+    long playoutsPerSecond;     //Playout rate
+};
+
+// Monte Carlo search tree that can be kept between moves
+struct MCTSTree;
+
+/// @brief Create an empty search tree
+/// @param board Root position board
+/// @param player Player to move in the root position
+/// @param playerStatus Player statuses of the root position
+/// @return Search tree or NULL on allocation failure
+struct MCTSTree* gamemcts_createTree(const struct KABoard* board, int player, const enum PlayerStatus playerStatus[4]);
+
+/// @brief Free a search tree
+/// @param tree Search tree (can be NULL)
+void gamemcts_freeTree(struct MCTSTree* tree);
+
+/// @brief Move the tree root along a played move, the search results of that move are kept
+/// @param tree Search tree
+/// @param x Tile X position of the move made by the root player
+/// @param y Tile Y position of the move made by the root player
+/// @return true if search results were kept, false if the tree was cleared
+bool gamemcts_playMove(struct MCTSTree* tree, int x, int y);
+
+/// @brief Move the tree root to a given position, the search results are kept only if it's the same as the root position
+/// @param tree Search tree
+/// @param board New root position board (must have the same grid size as the tree)
+/// @param player Player to move in the new root position
+/// @param playerStatus Player statuses of the new root position
+/// @return true if search results were kept, false if the tree was cleared
+bool gamemcts_setRoot(struct MCTSTree* tree, const struct KABoard* board, int player, const enum PlayerStatus playerStatus[4]);
+
+/// @brief Continue the search from the tree root until the budget is used up
+/// @param tree Search tree
+/// @param params Time and playout budget, search stops as soon as one of them is used up
+/// @param random Random number generator used by the playouts, extra pool threads get generators seeded from it
+/// @param result Search result
+/// @return true on success, false if the root player has no legal moves or the thread data couldn't be allocated
+bool gamemcts_search(struct MCTSTree* tree, const struct AIMCTSParams* params, KRandom* random, struct AIMCTSResult* result);
+
+/// @brief Find the best move with UCT Monte Carlo tree search. Playouts prefer tiles that explode right away and are played with gamelogic_resolveMove.
+/// @param board Current board
+/// @param player Player to find the move for
+/// @param playerStatus Current status of every player
+/// @param params Time and playout budget, search stops as soon as one of them is used up
+/// @param random Random number generator used by the playouts
+/// @param result Search result
+/// @return true on success, false if the player has no legal moves or the search data couldn't be allocated
+bool gamemcts_findMove(const struct KABoard* board, int player, const enum PlayerStatus playerStatus[4], const struct AIMCTSParams* params, KRandom* random, struct AIMCTSResult* result);
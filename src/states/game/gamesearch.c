@@ -0,0 +1,382 @@
+#include "gamesearch.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Amount of searched positions between time budget and cancellation checks
+#define SEARCH_TIME_CHECK_NODES 256
+
+// Win and loss scores at least this far from 0 depend on the ply they're found at
+#define SEARCH_WIN_THRESHOLD (SEARCH_WIN_SCORE-SEARCH_MAX_DEPTH-1)
+
+// Scores are from the searching player's point of view, so transposition table keys are different for every searching player
+static const uint64_t searchRootKeys[4] = {
+    0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL, 0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL
+};
+
+// Search state shared by every ply
+struct SearchContext {
+    int rootPlayer;                                     //Player the search is done for
+    int tileCount;                                      //Amount of tiles on the board
+    struct KABoard boards[SEARCH_MAX_DEPTH+1];          //Board of every ply (boards[0] is the root position)
+    enum PlayerStatus status[SEARCH_MAX_DEPTH+1][4];    //Player statuses of every ply
+    int* moves;                                         //Move lists of every ply (tileCount entries per ply)
+    Uint64 deadline;                                    //SDL_GetTicks64 value at which the search stops (0 = no time limit)
+    SDL_atomic_t* cancel;                               //Cancellation flag checked together with the deadline (can be NULL)
+    struct TransTable* table;                           //Transposition table (can be NULL)
+    const struct EvalWeights* weights;                  //Evaluation weights (NULL = default weights)
+    long nodes;                                         //Amount of searched positions
+    long tableProbes;                                   //Amount of transposition table lookups
+    long tableHits;                                     //Amount of lookups that found the position
+    bool aborted;                                       //Was the search stopped by the time limit
+};
+
+/// @brief Get the critical atom amount of a board tile
+/// @param board Compact board
+/// @param index Tile index
+/// @return Critical atom amount (2 for corners, 3 for sides, 4 otherwise)
+static int searchGetCrit(const struct KABoard* board, int index)
+{
+    int x = index % board->gridWidth;
+    int y = index / board->gridWidth;
+    return 4 - (x == 0 || x == board->gridWidth-1) - (y == 0 || y == board->gridHeight-1);
+}
+
+/// @brief List the legal moves of a player, tiles that explode right away come first
+/// @param board Compact board
+/// @param player Player making the move
+/// @param moves Array to write the tile indices to (needs space for every tile)
+/// @return Amount of moves
+static int generateMoves(const struct KABoard* board, int player, int* moves)
+{
+    int tileCount = board->gridWidth*board->gridHeight;
+    int moveCount = 0;
+    for(int i=0; i<tileCount; i++)
+    {
+        if(board->owner[i] == player && (int)board->count[i] == searchGetCrit(board,i)-1)
+            moves[moveCount++] = i;
+    }
+    for(int i=0; i<tileCount; i++)
+    {
+        if(board->owner[i] == NOOWNER || (board->owner[i] == player && (int)board->count[i] != searchGetCrit(board,i)-1))
+            moves[moveCount++] = i;
+    }
+    return moveCount;
+}
+
+static int searchNode(struct SearchContext* ctx, int ply, int depth, int player, int alpha, int beta);
+
+/// @brief Make a move on the next ply board and search the resulting position
+/// @param ctx Search context
+/// @param ply Ply of the position the move is made in
+/// @param index Tile index of the move
+/// @param player Player making the move
+/// @param depth Remaining search depth including this move
+/// @param alpha Alpha bound
+/// @param beta Beta bound
+/// @return Position score from the root player's point of view
+static int searchMove(struct SearchContext* ctx, int ply, int index, int player, int depth, int alpha, int beta)
+{
+    struct KABoard* board = &ctx->boards[ply+1];
+    enum PlayerStatus* status = ctx->status[ply+1];
+    gamelogic_copyBoard(board, &ctx->boards[ply]);
+    memcpy(status, ctx->status[ply], sizeof(ctx->status[ply]));
+    gamelogic_resolveMove(board, status, index % board->gridWidth, index / board->gridWidth, player);
+
+    ctx->nodes++;
+    if((ctx->nodes % SEARCH_TIME_CHECK_NODES) == 0 && ((ctx->deadline && SDL_GetTicks64() >= ctx->deadline) || (ctx->cancel && SDL_AtomicGet(ctx->cancel))))
+    {
+        ctx->aborted = true;
+        return 0;
+    }
+
+    bool playerWon = gamelogic_updatePlayerStatus(board, status, player);
+    if(status[ctx->rootPlayer] == PST_LOST)
+        return -SEARCH_WIN_SCORE+ply+1;
+    if(playerWon)
+        return SEARCH_WIN_SCORE-ply-1;
+    if(depth <= 1)
+        return gameeval_evaluate(ctx->weights, board, status, ctx->rootPlayer);
+    return searchNode(ctx, ply+1, depth-1, gamelogic_getNextPlayer(status,player), alpha, beta);
+}
+
+/// @brief Search a position where a given player has to move (the root player maximizes the score, the other players minimize it)
+/// @param ctx Search context
+/// @param ply Ply of the position
+/// @param depth Remaining search depth
+/// @param player Player to move
+/// @param alpha Alpha bound
+/// @param beta Beta bound
+/// @return Position score from the root player's point of view
+static int searchNode(struct SearchContext* ctx, int ply, int depth, int player, int alpha, int beta)
+{
+    int* moves = ctx->moves + ply*ctx->tileCount;
+    int moveCount = generateMoves(&ctx->boards[ply], player, moves);
+    if(moveCount == 0)
+        return gameeval_evaluate(ctx->weights, &ctx->boards[ply], ctx->status[ply], ctx->rootPlayer);
+
+    // A stored result searched at least as deep ends the search of this position if its bound allows it,
+    // otherwise its best move is searched first
+    uint64_t key = 0;
+    if(ctx->table)
+    {
+        key = gamelogic_getPositionKey(&ctx->boards[ply], ctx->status[ply], player) ^ searchRootKeys[ctx->rootPlayer];
+        struct TransEntry entry;
+        ctx->tableProbes++;
+        if(gametranstable_probe(ctx->table, key, &entry))
+        {
+            ctx->tableHits++;
+            int score = entry.score;
+            if(SDL_abs(score) >= SEARCH_WIN_THRESHOLD)
+                score += (score > 0) ? -ply : ply;
+            if(entry.depth >= depth && (entry.bound == TRANS_EXACT || (entry.bound == TRANS_LOWER && score >= beta) || (entry.bound == TRANS_UPPER && score <= alpha)))
+                return score;
+            for(int i=1; i<moveCount; i++)
+            {
+                if(moves[i] == entry.move)
+                {
+                    moves[i] = moves[0];
+                    moves[0] = entry.move;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool maximizing = (player == ctx->rootPlayer);
+    int originalAlpha = alpha;
+    int originalBeta = beta;
+    int bestScore = maximizing ? -SEARCH_WIN_SCORE-1 : SEARCH_WIN_SCORE+1;
+    int bestMove = moves[0];
+    for(int i=0; i<moveCount; i++)
+    {
+        int score = searchMove(ctx, ply, moves[i], player, depth, alpha, beta);
+        if(ctx->aborted)
+            return 0;
+        if(maximizing ? (score > bestScore) : (score < bestScore))
+        {
+            bestScore = score;
+            bestMove = moves[i];
+        }
+        if(maximizing)
+            alpha = SDL_max(alpha, score);
+        else
+            beta = SDL_min(beta, score);
+        if(alpha >= beta)
+            break;
+    }
+
+    if(ctx->table)
+    {
+        // Win and loss scores are stored relative to this position, so they stay valid at any ply
+        struct TransEntry entry = {bestScore, bestMove, depth, TRANS_EXACT};
+        if(SDL_abs(bestScore) >= SEARCH_WIN_THRESHOLD)
+            entry.score += (bestScore > 0) ? ply : -ply;
+        if(bestScore <= originalAlpha)
+            entry.bound = TRANS_UPPER;
+        else if(bestScore >= originalBeta)
+            entry.bound = TRANS_LOWER;
+        gametranstable_store(ctx->table, key, &entry);
+    }
+    return bestScore;
+}
+
+// Root moves of a single iteration, shared by every thread
+struct SearchRoot {
+    struct SearchContext** contexts;    //Search context of every thread
+    int player;                         //Player the search is done for
+    int depth;                          //Depth of the iteration
+    int* moves;                         //Root moves
+    int* scores;                        //Root move scores, moves that didn't beat the best score found before them get a lower score than it
+    SDL_atomic_t alpha;                 //Best root move score found so far
+};
+
+// Root move searched as a thread pool task
+struct SearchRootTask {
+    struct SearchRoot* root;
+    int index;                          //Index of the move in the root move array
+};
+
+/// @brief Search a single root move with the best score found so far by any thread as the alpha bound
+/// @param data Root move task
+/// @param threadIndex Index of the thread running the task
+static void searchRootMove(void* data, int threadIndex)
+{
+    struct SearchRootTask* task = data;
+    struct SearchRoot* root = task->root;
+    struct SearchContext* ctx = root->contexts[threadIndex];
+    if(ctx->aborted)
+        return;
+    int alpha = SDL_AtomicGet(&root->alpha);
+    int score = searchMove(ctx, 0, root->moves[task->index], root->player, root->depth, alpha, SEARCH_WIN_SCORE+1);
+    if(ctx->aborted)
+        return;
+    // A score that doesn't beat alpha is only an upper bound, so it can't tie with the move that set alpha
+    root->scores[task->index] = (score > alpha) ? score : SDL_min(score, alpha-1);
+    while(score > alpha && !SDL_AtomicCAS(&root->alpha, alpha, score))
+        alpha = SDL_AtomicGet(&root->alpha);
+}
+
+/// @brief Free a search context
+/// @param ctx Search context (can be NULL)
+static void freeSearchContext(struct SearchContext* ctx)
+{
+    if(!ctx)
+        return;
+    for(int i=0; i<=SEARCH_MAX_DEPTH; i++)
+        gamelogic_freeBoard(&ctx->boards[i]);
+    free(ctx->moves);
+    free(ctx);
+}
+
+/// @brief Allocate a search context for a position
+/// @param board Root position board
+/// @param player Player the search is done for
+/// @param playerStatus Root position player statuses
+/// @param params Search params
+/// @param maxDepth Max search depth
+/// @return Search context or NULL on allocation failure
+static struct SearchContext* allocSearchContext(const struct KABoard* board, int player, const enum PlayerStatus playerStatus[4], const struct AISearchParams* params, int maxDepth)
+{
+    struct SearchContext* ctx = calloc(1,sizeof(struct SearchContext));
+    if(!ctx)
+        return NULL;
+    ctx->rootPlayer = player;
+    ctx->tileCount = board->gridWidth*board->gridHeight;
+    ctx->moves = malloc((maxDepth+1)*ctx->tileCount*sizeof(int));
+    bool allocated = (ctx->moves != NULL);
+    for(int i=0; i<=maxDepth && allocated; i++)
+        allocated = gamelogic_allocBoard(&ctx->boards[i], board->gridWidth, board->gridHeight);
+    if(!allocated)
+    {
+        freeSearchContext(ctx);
+        return NULL;
+    }
+    gamelogic_copyBoard(&ctx->boards[0], board);
+    memcpy(ctx->status[0], playerStatus, sizeof(ctx->status[0]));
+    if(params->timeLimit > 0)
+        ctx->deadline = SDL_GetTicks64() + params->timeLimit;
+    ctx->cancel = params->cancel;
+    ctx->table = params->table;
+    ctx->weights = params->weights;
+    return ctx;
+}
+
+bool gamesearch_findMove(const struct KABoard* board, int player, const enum PlayerStatus playerStatus[4], const Vec2* moveHints, int moveHintCount, const struct AISearchParams* params, struct AISearchResult* result)
+{
+    int maxDepth = SDL_clamp(params->maxDepth, 1, SEARCH_MAX_DEPTH);
+    int threadCount = params->threadPool ? kthreadpool_getThreadCount(params->threadPool) : 1;
+    int tileCount = board->gridWidth*board->gridHeight;
+    if(params->table)
+        gametranstable_newSearch(params->table);
+    struct SearchContext* contexts[KTHREADPOOL_MAX_THREADS] = {NULL};
+    struct SearchRoot root = {contexts, player, 0, NULL, NULL, {0}};
+    root.moves = malloc(tileCount*sizeof(int));
+    root.scores = malloc(tileCount*sizeof(int));
+    struct SearchRootTask* tasks = malloc(tileCount*sizeof(struct SearchRootTask));
+    uint8_t* isListed = calloc(tileCount,1);
+    bool allocated = (root.moves && root.scores && tasks && isListed);
+    for(int i=0; i<threadCount && allocated; i++)
+        allocated = ((contexts[i] = allocSearchContext(board, player, playerStatus, params, maxDepth)) != NULL);
+
+    // Root moves: legal hinted moves first, then every other legal move
+    int rootMoveCount = 0;
+    for(int i=0; i<moveHintCount && allocated; i++)
+    {
+        Vec2 hint = moveHints[i];
+        if(hint.x < 0 || hint.x >= board->gridWidth || hint.y < 0 || hint.y >= board->gridHeight)
+            continue;
+        int index = BOARD_INDEX(board,hint.x,hint.y);
+        if(isListed[index] || (board->owner[index] != NOOWNER && board->owner[index] != player))
+            continue;
+        isListed[index] = 1;
+        root.moves[rootMoveCount++] = index;
+    }
+    if(allocated)
+    {
+        int* allMoves = contexts[0]->moves;
+        int allMoveCount = generateMoves(board, player, allMoves);
+        for(int i=0; i<allMoveCount; i++)
+        {
+            if(!isListed[allMoves[i]])
+                root.moves[rootMoveCount++] = allMoves[i];
+        }
+    }
+    free(isListed);
+    if(!allocated || rootMoveCount == 0)
+    {
+        free(root.moves);
+        free(root.scores);
+        free(tasks);
+        for(int i=0; i<threadCount; i++)
+            freeSearchContext(contexts[i]);
+        return false;
+    }
+
+    result->move = (Vec2){root.moves[0] % board->gridWidth, root.moves[0] / board->gridWidth};
+    result->score = 0;
+    result->depth = 0;
+
+    // Iterative deepening, every finished depth reorders the root moves for the next one.
+    // The first move is searched alone to get a good alpha bound, the rest is split across the thread pool.
+    bool aborted = false;
+    for(int depth=1; depth<=maxDepth && !aborted; depth++)
+    {
+        root.depth = depth;
+        SDL_AtomicSet(&root.alpha, -SEARCH_WIN_SCORE-1);
+        for(int i=0; i<rootMoveCount; i++)
+        {
+            tasks[i] = (struct SearchRootTask){&root, i};
+            if(i == 0 || !params->threadPool || !kthreadpool_submit(params->threadPool, searchRootMove, &tasks[i]))
+                searchRootMove(&tasks[i], 0);
+        }
+        if(params->threadPool)
+            kthreadpool_wait(params->threadPool);
+        for(int i=0; i<threadCount; i++)
+            aborted |= contexts[i]->aborted;
+        if(aborted)
+            break;
+
+        int bestMove = 0;
+        for(int i=1; i<rootMoveCount; i++)
+        {
+            if(root.scores[i] > root.scores[bestMove])
+                bestMove = i;
+        }
+        int bestScore = root.scores[bestMove];
+        result->move = (Vec2){root.moves[bestMove] % board->gridWidth, root.moves[bestMove] / board->gridWidth};
+        result->score = bestScore;
+        result->depth = depth;
+        for(int i=1; i<rootMoveCount; i++)
+        {
+            int move = root.moves[i];
+            int score = root.scores[i];
+            int j = i;
+            for(; j>0 && root.scores[j-1] < score; j--)
+            {
+                root.moves[j] = root.moves[j-1];
+                root.scores[j] = root.scores[j-1];
+            }
+            root.moves[j] = move;
+            root.scores[j] = score;
+        }
+        // A forced win or loss can't change with a deeper search
+        if(SDL_abs(bestScore) >= SEARCH_WIN_SCORE-SEARCH_MAX_DEPTH)
+            break;
+    }
+
+    result->nodes = 0;
+    result->tableProbes = 0;
+    result->tableHits = 0;
+    for(int i=0; i<threadCount; i++)
+    {
+        result->nodes += contexts[i]->nodes;
+        result->tableProbes += contexts[i]->tableProbes;
+        result->tableHits += contexts[i]->tableHits;
+        freeSearchContext(contexts[i]);
+    }
+    free(root.moves);
+    free(root.scores);
+    free(tasks);
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "gamelogic.h"
+#include "gameeval.h"
+#include "gametranstable.h"
+#include "../../utils/threadpool.h"
+
+// Max search depth in plies (one ply is a single player move)
+#define SEARCH_MAX_DEPTH 16
+
+// Score of a won position (lowered by the amount of plies needed to win)
+#define SEARCH_WIN_SCORE 1000000
+
+// Budget of the alpha-beta search
+struct AISearchParams {
+    int maxDepth;   //Max search depth in plies (1-SEARCH_MAX_DEPTH)
+    int timeLimit;  //Time budget in milliseconds, the last fully searched depth is used when it runs out (0 = no limit)
+    SDL_atomic_t* cancel;   //The search stops like on a time limit as soon as this is set to a non-zero value (can be NULL)
+    KThreadPool* threadPool;    //Thread pool the root moves are split across (NULL = search on the calling thread only)
+    struct TransTable* table;   //Transposition table shared by the search threads and kept between searches (NULL = no table)
+    const struct EvalWeights* weights;  //Weights of the position evaluation (NULL = gameeval_defaultWeights), the table has to be cleared when they change
+};
+
+// Outcome of the alpha-beta search
+struct AISearchResult {
+    Vec2 move;      //Best move found
+    int score;      //Move score from the searching player's point of view
+    int depth;      //Last fully searched depth (0 if not even depth 1 was finished in time)
+    long nodes;     //Amount of searched positions
+    long tableProbes;   //Amount of transposition table lookups
+    long tableHits;     //Amount of lookups that found the position
+};
+
+/// @brief Find the best move with paranoid alpha-beta search (every other player is assumed to play against the searching player)
+/// @param board Current board
+/// @param player Player to find the move for
+/// @param playerStatus Current status of every player
+/// @param moveHints Moves to search first (in the given order), for example the moves picked by the rule-based AI. May contain duplicates.
+/// @param moveHintCount Amount of moves in moveHints
+/// @param params Search depth and time budget
+/// @param result Search result, the move is set to the first legal move if the search didn't finish depth 1 in time
+/// @return true on success, false if the player has no legal moves or the search data couldn't be allocated
+bool gamesearch_findMove(const struct KABoard* board, int player, const enum PlayerStatus playerStatus[4], const Vec2* moveHints, int moveHintCount, const struct AISearchParams* params, struct AISearchResult* result);
@@ -2,6 +2,7 @@
 #include "gamelogic.h"
 #include "gamedraw.h"
 #include "gametutorial.h"
+#include "gameai.h"
 #include "../../game/save.h"
 #include "../../game/game.h"
 #include "../../game/state.h"
@@ -72,8 +73,31 @@ static void doSelectorMovement(int x, int y)
     checkSelectorMovement();
 }
 
+/// @brief Close the game with a game logic error message
+/// @param str Error message
+static void presentError(const char* str)
+{
+    game_errorMsg("%s",str);
+}
+
+/// @brief Play the sound of a game event
+/// @param event Game event
+/// @param tileCount Amount of tiles the event happened on
+static void presentEvent(enum GameEvent event, int tileCount)
+{
+    if(event == GEV_ATOMPUT)
+        wavplayer_play(sfxPut);
+    // Long chain reactions would only play the same sound over and over
+    else if(event == GEV_EXPLOSION && logicData->explosionCount < 1000)
+        wavplayer_play(sfxExplode);
+}
+
+// Presentation callbacks of the game logic, messages are drawn by the game and sounds go to the WAV player
+static const struct GamePresenter gamePresenter = {game_printMsg, presentError, presentEvent};
+
 void gamestate_init(SDL_Renderer* rend)
 {
+    gamelogic_setPresenter(&gamePresenter);
     tutorialFinished = true;
     pausedMillis = -1;
     gamePaused = false;
@@ -83,13 +107,13 @@ void gamestate_init(SDL_Renderer* rend)
     if(launchedTutorial)
     {
         int tutPlayerTypes[4] = {1,1,1,1};
-        gamelogic_init(10, 6, &tutPlayerTypes);
+        gamelogic_init(10, 6, &tutPlayerTypes, EXPLOSION_SEQUENTIAL, game_newSeed());
         gametutorial_init();
     }
     else
     {
         int playerTypes[4] = {gameSettings.player1Type, gameSettings.player2Type, gameSettings.player3Type, gameSettings.player4Type};
-        gamelogic_init(gameSettings.gridWidth, gameSettings.gridHeight, &playerTypes);
+        gamelogic_init(gameSettings.gridWidth, gameSettings.gridHeight, &playerTypes, gameSettings.explosionMode, game_newSeed());
         ttime = loadGame();
     }
     gamedraw_initAssets(logicData->gridWidth, logicData->gridHeight);
@@ -122,6 +146,7 @@ void gamestate_update(float dt)
         {
             game_printMsg("",0);
             gamePausing = false;
+            ai_Cancel();
             pausedMillis = ktimer_getTimeMillis(gameTimer);
             gamePaused = true;
             return;
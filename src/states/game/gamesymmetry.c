@@ -0,0 +1,136 @@
+#include "gamesymmetry.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+
+/// @brief Get the position of a tile after a transform
+/// @param transform Transform
+/// @param gridWidth Grid width
+/// @param gridHeight Grid height
+/// @param x Tile X position
+/// @param y Tile Y position
+/// @return Transformed tile position
+static Vec2 symTransformPos(int transform, int gridWidth, int gridHeight, int x, int y)
+{
+    switch(transform)
+    {
+        case SYM_FLIPX:
+            return (Vec2){gridWidth-1-x, y};
+        case SYM_FLIPY:
+            return (Vec2){x, gridHeight-1-y};
+        case SYM_ROTATE180:
+            return (Vec2){gridWidth-1-x, gridHeight-1-y};
+        case SYM_TRANSPOSE:
+            return (Vec2){y, x};
+        case SYM_ROTATE90:
+            return (Vec2){gridHeight-1-y, x};
+        case SYM_ROTATE270:
+            return (Vec2){y, gridWidth-1-x};
+        case SYM_ANTITRANSPOSE:
+            return (Vec2){gridHeight-1-y, gridWidth-1-x};
+        default:
+            return (Vec2){x, y};
+    }
+}
+
+bool gamesymmetry_init(struct KASymmetry* sym, int gridWidth, int gridHeight)
+{
+    *sym = (struct KASymmetry){0};
+    if(gridWidth < 1 || gridWidth > MAX_GRID_WIDTH || gridHeight < 1 || gridHeight > MAX_GRID_HEIGHT)
+        return false;
+    sym->gridWidth = gridWidth;
+    sym->gridHeight = gridHeight;
+    sym->transformCount = (gridWidth == gridHeight) ? 8 : 4;
+    int tileCount = gridWidth*gridHeight;
+    for(int t=0; t<sym->transformCount; t++)
+    {
+        sym->map[t] = malloc(tileCount*sizeof(uint16_t));
+        sym->unmap[t] = malloc(tileCount*sizeof(uint16_t));
+        if(!sym->map[t] || !sym->unmap[t])
+        {
+            gamesymmetry_free(sym);
+            return false;
+        }
+        for(int y=0; y<gridHeight; y++)
+        {
+            for(int x=0; x<gridWidth; x++)
+            {
+                // Transforms of square grids keep the size, so the transformed index uses the same width
+                Vec2 pos = symTransformPos(t, gridWidth, gridHeight, x, y);
+                int index = y*gridWidth+x;
+                int newIndex = pos.y*gridWidth+pos.x;
+                sym->map[t][index] = newIndex;
+                sym->unmap[t][newIndex] = index;
+            }
+        }
+    }
+    return true;
+}
+
+void gamesymmetry_free(struct KASymmetry* sym)
+{
+    for(int t=0; t<SYMMETRY_MAX_TRANSFORMS; t++)
+    {
+        free(sym->map[t]);
+        free(sym->unmap[t]);
+    }
+    *sym = (struct KASymmetry){0};
+}
+
+int gamesymmetry_canonicalize(const struct KASymmetry* sym, const struct KABoard* board, const int ownerMap[4], uint64_t* key)
+{
+    uint64_t keys[SYMMETRY_MAX_TRANSFORMS] = {0};
+    // Empty tiles have no key, so mostly empty boards (like openings) are cheap
+    for(int i=0; i<sym->gridWidth*sym->gridHeight; i++)
+    {
+        int owner = board->owner[i];
+        if(owner == NOOWNER)
+            continue;
+        if(ownerMap)
+            owner = ownerMap[owner];
+        for(int t=0; t<sym->transformCount; t++)
+            keys[t] ^= gamelogic_getTileKey(sym->map[t][i], owner, board->count[i]);
+    }
+    int bestTransform = 0;
+    for(int t=1; t<sym->transformCount; t++)
+    {
+        if(keys[t] < keys[bestTransform])
+            bestTransform = t;
+    }
+    *key = keys[bestTransform];
+    return bestTransform;
+}
+
+int gamesymmetry_getInverse(int transform)
+{
+    if(transform == SYM_ROTATE90)
+        return SYM_ROTATE270;
+    if(transform == SYM_ROTATE270)
+        return SYM_ROTATE90;
+    return transform;
+}
+
+int gamesymmetry_transformMove(const struct KASymmetry* sym, int transform, int index)
+{
+    return sym->map[transform][index];
+}
+
+int gamesymmetry_untransformMove(const struct KASymmetry* sym, int transform, int index)
+{
+    return sym->unmap[transform][index];
+}
+
+void gamesymmetry_transformBoard(const struct KASymmetry* sym, int transform, struct KABoard* dst, const struct KABoard* src)
+{
+    int tileCount = sym->gridWidth*sym->gridHeight;
+    dst->explosionMode = src->explosionMode;
+    dst->hash = 0;
+    for(int p=0; p<4; p++)
+        dst->playerAtoms[p] = src->playerAtoms[p];
+    for(int i=0; i<tileCount; i++)
+    {
+        int newIndex = sym->map[transform][i];
+        dst->owner[newIndex] = src->owner[i];
+        dst->count[newIndex] = src->count[i];
+        dst->hash ^= gamelogic_getTileKey(newIndex, src->owner[i], src->count[i]);
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gamelogic.h"
+
+// Max amount of symmetry transforms of a grid (square grids have 8, other grids have 4)
+#define SYMMETRY_MAX_TRANSFORMS 8
+
+// Grid transforms, the first 4 are valid for every grid size, the rest only for square grids
+enum SymmetryTransform {
+    SYM_IDENTITY,       //(x, y)
+    SYM_FLIPX,          //(w-1-x, y)
+    SYM_FLIPY,          //(x, h-1-y)
+    SYM_ROTATE180,      //(w-1-x, h-1-y)
+    SYM_TRANSPOSE,      //(y, x)
+    SYM_ROTATE90,       //(h-1-y, x) clockwise
+    SYM_ROTATE270,      //(y, w-1-x) clockwise
+    SYM_ANTITRANSPOSE   //(h-1-y, w-1-x)
+};
+
+// Tile index permutations of every transform of a grid size, built once and shared by every board of that size.
+// Transformed positions play the same, except that atoms above the critical amount of an exploding tile always go to the tile below it,
+// so positions stay equivalent until a chain reaction explodes an overloaded tile.
+struct KASymmetry {
+    int gridWidth;
+    int gridHeight;
+    int transformCount;                             //Amount of valid transforms (4 or 8)
+    uint16_t* map[SYMMETRY_MAX_TRANSFORMS];         //Tile index after the transform for every tile index
+    uint16_t* unmap[SYMMETRY_MAX_TRANSFORMS];       //Tile index before the transform for every transformed tile index
+};
+
+/// @brief Build the permutation tables of a grid size
+/// @param sym Symmetry data to initialize
+/// @param gridWidth Grid width (1-MAX_GRID_WIDTH)
+/// @param gridHeight Grid height (1-MAX_GRID_HEIGHT)
+/// @return true on success, false if the size is invalid or the tables couldn't be allocated
+bool gamesymmetry_init(struct KASymmetry* sym, int gridWidth, int gridHeight);
+
+/// @brief Free the permutation tables
+/// @param sym Symmetry data initialized by gamesymmetry_init (can be all zero)
+void gamesymmetry_free(struct KASymmetry* sym);
+
+/// @brief Find the canonical orientation of a board, the transform that gives the lowest tile key (any of them if the board is symmetric)
+/// @param sym Symmetry data of the board size
+/// @param board Board
+/// @param ownerMap Tile owner used in the key for every player (NULL = keep the player numbers), for example to number the players from the player to move
+/// @param key Canonical tile key to write to (XOR of gamelogic_getTileKey of every tile in the canonical orientation)
+/// @return Transform to the canonical orientation
+int gamesymmetry_canonicalize(const struct KASymmetry* sym, const struct KABoard* board, const int ownerMap[4], uint64_t* key);
+
+/// @brief Get the transform that undoes a transform
+/// @param transform Transform
+/// @return Inverse transform
+int gamesymmetry_getInverse(int transform);
+
+/// @brief Transform a tile index (a move or a tile of a position)
+/// @param sym Symmetry data of the board size
+/// @param transform Transform
+/// @param index Tile index
+/// @return Transformed tile index
+int gamesymmetry_transformMove(const struct KASymmetry* sym, int transform, int index);
+
+/// @brief Undo the transform of a tile index, for example to map a move found in the canonical orientation back to the real board
+/// @param sym Symmetry data of the board size
+/// @param transform Transform that was applied
+/// @param index Transformed tile index
+/// @return Tile index before the transform
+int gamesymmetry_untransformMove(const struct KASymmetry* sym, int transform, int index);
+
+/// @brief Write a transformed copy of a board
+/// @param sym Symmetry data of the board size
+/// @param transform Transform
+/// @param dst Destination board, allocated with the same size as src (can't be src)
+/// @param src Source board
+void gamesymmetry_transformBoard(const struct KASymmetry* sym, int transform, struct KABoard* dst, const struct KABoard* src);
@@ -0,0 +1,135 @@
+#include "gametablebase.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Tablebase {
+    uint8_t* data;              //Tablebase file data
+    const uint8_t* entries;     //First entry in data
+    long entryCount;
+    int gridWidth;
+    int gridHeight;
+    enum ExplosionMode explosionMode;
+};
+
+/// @brief Mix a value into a 64-bit key (splitmix64 finalizer)
+/// @param value Value to mix
+/// @return Mixed key
+static uint64_t tbMix(uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+static uint16_t tbReadLE16(const uint8_t* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+static uint32_t tbReadLE32(const uint8_t* data)
+{
+    return tbReadLE16(data) | ((uint32_t)tbReadLE16(data+2) << 16);
+}
+
+static uint64_t tbReadLE64(const uint8_t* data)
+{
+    return tbReadLE32(data) | ((uint64_t)tbReadLE32(data+4) << 32);
+}
+
+struct Tablebase* gametablebase_open(void* data, size_t size)
+{
+    const uint8_t* header = data;
+    if(size < TABLEBASE_HEADER_SIZE || memcmp(header, TABLEBASE_MAGIC, 4) != 0 || tbReadLE16(header+4) != TABLEBASE_VERSION)
+        return NULL;
+    uint32_t entryCount = tbReadLE32(header+12);
+    if(entryCount > (size-TABLEBASE_HEADER_SIZE)/TABLEBASE_ENTRY_SIZE)
+        return NULL;
+    struct Tablebase* tablebase = malloc(sizeof(struct Tablebase));
+    if(!tablebase)
+        return NULL;
+    tablebase->data = data;
+    tablebase->entries = tablebase->data+TABLEBASE_HEADER_SIZE;
+    tablebase->entryCount = entryCount;
+    tablebase->gridWidth = tbReadLE16(header+6);
+    tablebase->gridHeight = tbReadLE16(header+8);
+    tablebase->explosionMode = tbReadLE16(header+10);
+    return tablebase;
+}
+
+void gametablebase_free(struct Tablebase* tablebase)
+{
+    if(!tablebase)
+        return;
+    free(tablebase->data);
+    free(tablebase);
+}
+
+bool gametablebase_getKey(const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, uint64_t* key)
+{
+    int opponent = NOPLAYER;
+    for(int p=0; p<4; p++)
+    {
+        // A player who lost has no atoms left, so the game plays like a 2 player game from then on
+        if(p == player || playerStatus[p] <= PST_LOST)
+            continue;
+        if(opponent != NOPLAYER)
+            return false;
+        opponent = p;
+    }
+    if(opponent == NOPLAYER || playerStatus[player] <= PST_LOST)
+        return false;
+
+    // Tiles of the player to move use owner 0, tiles of the opponent use owner 1
+    uint64_t positionKey = 0;
+    for(int i=0; i<board->gridWidth*board->gridHeight; i++)
+    {
+        if(board->owner[i] != NOOWNER)
+            positionKey ^= gamelogic_getTileKey(i, (board->owner[i] == player) ? 0 : 1, board->count[i]);
+    }
+    if(playerStatus[player] == PST_NOTSTARTED)
+        positionKey ^= tbMix(1);
+    if(playerStatus[opponent] == PST_NOTSTARTED)
+        positionKey ^= tbMix(2);
+    *key = positionKey;
+    return true;
+}
+
+enum TablebaseResult gametablebase_probe(const struct Tablebase* tablebase, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, int* move)
+{
+    uint64_t key;
+    if(!tablebase || board->gridWidth != tablebase->gridWidth || board->gridHeight != tablebase->gridHeight || board->explosionMode != tablebase->explosionMode
+        || !gametablebase_getKey(board, playerStatus, player, &key))
+        return TB_UNKNOWN;
+    long low = 0;
+    long high = tablebase->entryCount-1;
+    while(low <= high)
+    {
+        long mid = low + (high-low)/2;
+        const uint8_t* entry = tablebase->entries + mid*TABLEBASE_ENTRY_SIZE;
+        uint64_t entryKey = tbReadLE64(entry);
+        if(entryKey < key)
+        {
+            low = mid+1;
+        }
+        else if(entryKey > key)
+        {
+            high = mid-1;
+        }
+        else
+        {
+            enum TablebaseResult result = entry[10];
+            if(result == TB_WIN)
+            {
+                // A key collision could give a move that isn't legal in this position
+                int winMove = tbReadLE16(entry+8);
+                if(winMove >= board->gridWidth*board->gridHeight || (board->owner[winMove] != NOOWNER && board->owner[winMove] != player))
+                    return TB_UNKNOWN;
+                *move = winMove;
+            }
+            return (result == TB_WIN || result == TB_LOSS) ? result : TB_UNKNOWN;
+        }
+    }
+    return TB_UNKNOWN;
+}
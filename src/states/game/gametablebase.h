@@ -0,0 +1,58 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "gamelogic.h"
+
+// Tablebase file magic number
+#define TABLEBASE_MAGIC "KATB"
+
+// Tablebase file format version, has to be raised when the file layout or the position keys change
+#define TABLEBASE_VERSION 1
+
+// Size of the tablebase file header
+#define TABLEBASE_HEADER_SIZE 16
+
+// Size of a tablebase file entry
+#define TABLEBASE_ENTRY_SIZE 12
+
+// Perfect play result of a position for the player to move
+enum TablebaseResult {
+    TB_UNKNOWN, //The position isn't in the tablebase
+    TB_LOSS,    //The player to move loses whatever they play
+    TB_WIN      //The player to move wins by playing the stored move
+};
+
+// Exact win/loss results of 2 player positions of a single grid size and explosion mode.
+// The file starts with TABLEBASE_MAGIC, the version, grid width, grid height and explosion mode (LE16 each) and the entry count (LE32),
+// followed by fixed-size entries sorted by key: position key (LE64), move (LE16), result (8 bits) and a padding byte.
+// The entries are searched in place, so the file can be used straight from a memory mapping or a loaded PAK entry.
+struct Tablebase;
+
+/// @brief Open a tablebase from a file loaded to memory
+/// @param data Tablebase file data allocated with malloc, the tablebase takes ownership of it on success
+/// @param size Tablebase file size in bytes
+/// @return Tablebase or NULL if the data is invalid (the data isn't freed then)
+struct Tablebase* gametablebase_open(void* data, size_t size);
+
+/// @brief Free a tablebase and its data
+/// @param tablebase Tablebase (can be NULL)
+void gametablebase_free(struct Tablebase* tablebase);
+
+/// @brief Get the tablebase key of a position, players are numbered from the player to move, so the key doesn't depend on the player slots used.
+/// Unlike the opening book, tablebases don't merge mirrored positions, as the extra atoms of overloaded explosions make the rules slightly asymmetric.
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @param player Player to move
+/// @param key Key to write to
+/// @return true if the position can be in a tablebase (exactly 2 players left in the game), false otherwise
+bool gametablebase_getKey(const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, uint64_t* key);
+
+/// @brief Look the result of a position up
+/// @param tablebase Tablebase (can be NULL)
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @param player Player to move
+/// @param move Tile index of the winning move to write to (only written for TB_WIN)
+/// @return Position result or TB_UNKNOWN if the position isn't in the tablebase
+enum TablebaseResult gametablebase_probe(const struct Tablebase* tablebase, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, int* move);
@@ -0,0 +1,392 @@
+#include "gametablebasegen.h"
+#include "gamesearch.h"
+#include "gametranstable.h"
+#include "../../utils/threadpool.h"
+#include "../../utils/timer.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Transposition table size of the solver in megabytes, it keeps the results proven by every thread
+#define TABLEBASE_TABLESIZE 256
+
+// Amount of playouts tried for every random position before giving up on it
+#define TABLEBASE_PLAYOUT_TRIES 64
+
+// Amount of random moves at the start of every playout, the rest of the moves are picked by a shallow AI search
+#define TABLEBASE_PLAYOUT_RANDOMPLIES 4
+
+// Search depth of the playout moves
+#define TABLEBASE_PLAYOUT_DEPTH 2
+
+// Solver state of a single thread, every ply has the positions after every move of the player to move
+struct TablebaseSolver {
+    struct TablebaseGenerator* gen;
+    int tileCount;
+    int maxPly;                             //Amount of plies the solver data has space for
+    struct KABoard* children;               //Positions after every move of every ply (tileCount boards per ply)
+    enum PlayerStatus (*childStatus)[4];    //Player statuses of the children
+    int* order;                             //Search order of the children of every ply (tileCount entries per ply)
+    int* explosions;                        //Explosion count of the move leading to every child
+    long nodes;                             //Amount of positions visited for the current random position
+    long totalNodes;                        //Amount of positions visited for every random position
+    struct TablebaseEntry* entries;         //Positions proven by this thread
+    long entryCount;
+    long entryCapacity;
+    int results[3];                         //Result count of the random positions
+    bool failed;                            //Did an allocation fail
+};
+
+// Tablebase generator state shared by every thread
+struct TablebaseGenerator {
+    struct TablebaseParams params;
+    struct TransTable* table;   //Proven positions of every thread (score 1 for TB_WIN, -1 for TB_LOSS)
+    SDL_atomic_t nextRoot;      //Next random position to solve
+};
+
+/// @brief Compare tablebase entries by key (qsort callback)
+static int tbCompareEntries(const void* a, const void* b)
+{
+    uint64_t keyA = ((const struct TablebaseEntry*)a)->key;
+    uint64_t keyB = ((const struct TablebaseEntry*)b)->key;
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+long gametablebasegen_write(const char* path, int gridWidth, int gridHeight, enum ExplosionMode explosionMode, struct TablebaseEntry* entries, long entryCount)
+{
+    qsort(entries, entryCount, sizeof(struct TablebaseEntry), tbCompareEntries);
+    long uniqueCount = 0;
+    for(long i=0; i<entryCount; i++)
+    {
+        if(uniqueCount == 0 || entries[i].key != entries[uniqueCount-1].key)
+            entries[uniqueCount++] = entries[i];
+    }
+
+    SDL_RWops* file = SDL_RWFromFile(path, "wb");
+    if(!file)
+        return -1;
+    bool written = (SDL_RWwrite(file, TABLEBASE_MAGIC, 1, 4) == 4);
+    written = written && SDL_WriteLE16(file, TABLEBASE_VERSION) && SDL_WriteLE16(file, gridWidth) && SDL_WriteLE16(file, gridHeight)
+        && SDL_WriteLE16(file, explosionMode) && SDL_WriteLE32(file, uniqueCount);
+    for(long i=0; i<uniqueCount && written; i++)
+    {
+        written = SDL_WriteLE64(file, entries[i].key) && SDL_WriteLE16(file, (entries[i].result == TB_WIN) ? entries[i].move : 0)
+            && SDL_WriteU8(file, entries[i].result) && SDL_WriteU8(file, 0);
+    }
+    if(SDL_RWclose(file) != 0)
+        written = false;
+    return written ? uniqueCount : -1;
+}
+
+/// @brief Free the data of a solver thread
+/// @param solver Solver thread
+static void tbFreeSolver(struct TablebaseSolver* solver)
+{
+    if(solver->children)
+    {
+        for(int i=0; i<solver->maxPly*solver->tileCount; i++)
+            gamelogic_freeBoard(&solver->children[i]);
+    }
+    free(solver->children);
+    free(solver->childStatus);
+    free(solver->order);
+    free(solver->explosions);
+    free(solver->entries);
+    memset(solver, 0, sizeof(struct TablebaseSolver));
+}
+
+/// @brief Allocate the data of a solver thread
+/// @param solver Solver thread to initialize
+/// @param gen Tablebase generator
+/// @return true on success, false on allocation failure
+static bool tbInitSolver(struct TablebaseSolver* solver, struct TablebaseGenerator* gen)
+{
+    memset(solver, 0, sizeof(struct TablebaseSolver));
+    solver->gen = gen;
+    solver->tileCount = gen->params.gridWidth*gen->params.gridHeight;
+    // Every move adds an atom and a position that isn't won never has more than 3 atoms on a tile, so no game is longer than this
+    solver->maxPly = 3*solver->tileCount+2;
+    int childCount = solver->maxPly*solver->tileCount;
+    solver->children = calloc(childCount, sizeof(struct KABoard));
+    solver->childStatus = malloc(childCount*sizeof(solver->childStatus[0]));
+    solver->order = malloc(childCount*sizeof(int));
+    solver->explosions = malloc(childCount*sizeof(int));
+    if(!solver->children || !solver->childStatus || !solver->order || !solver->explosions)
+    {
+        tbFreeSolver(solver);
+        return false;
+    }
+    for(int i=0; i<childCount; i++)
+    {
+        if(!gamelogic_allocBoard(&solver->children[i], gen->params.gridWidth, gen->params.gridHeight))
+        {
+            tbFreeSolver(solver);
+            return false;
+        }
+        solver->children[i].explosionMode = gen->params.explosionMode;
+    }
+    return true;
+}
+
+/// @brief Remember a proven position in the transposition table and the entries of the thread
+/// @param solver Solver thread
+/// @param key Position key
+/// @param result Position result
+/// @param move Tile index of the winning move (only for TB_WIN)
+/// @param proofNodes Amount of positions visited by the proof, positions with small proofs are only kept in the transposition table
+static void tbStoreResult(struct TablebaseSolver* solver, uint64_t key, enum TablebaseResult result, int move, long proofNodes)
+{
+    struct TransEntry entry = {(result == TB_WIN) ? 1 : -1, move, 1, TRANS_EXACT};
+    gametranstable_store(solver->gen->table, key, &entry);
+    if(proofNodes < solver->gen->params.minProofNodes)
+        return;
+    if(solver->entryCount >= solver->entryCapacity)
+    {
+        long newCapacity = SDL_max(solver->entryCapacity*2, 4096);
+        struct TablebaseEntry* newEntries = realloc(solver->entries, newCapacity*sizeof(struct TablebaseEntry));
+        if(!newEntries)
+        {
+            solver->failed = true;
+            return;
+        }
+        solver->entries = newEntries;
+        solver->entryCapacity = newCapacity;
+    }
+    solver->entries[solver->entryCount++] = (struct TablebaseEntry){key, move, result};
+}
+
+/// @brief Prove the result of a position with an exhaustive search, the position is won if any move leads to a lost position for the opponent and lost if every move leads to a won one
+/// @param solver Solver thread
+/// @param ply Ply of the position from the random position
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @param player Player to move
+/// @param move Tile index of the winning move to write to (only written for TB_WIN)
+/// @return Position result or TB_UNKNOWN if the node limit ran out before it was proven
+static enum TablebaseResult tbSolve(struct TablebaseSolver* solver, int ply, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, int* move)
+{
+    uint64_t key;
+    if(ply >= solver->maxPly || !gametablebase_getKey(board, playerStatus, player, &key))
+        return TB_UNKNOWN;
+    struct TransEntry entry;
+    if(gametranstable_probe(solver->gen->table, key, &entry))
+    {
+        if(entry.score > 0)
+            *move = entry.move;
+        return (entry.score > 0) ? TB_WIN : TB_LOSS;
+    }
+    if(solver->nodes >= solver->gen->params.nodeLimit)
+        return TB_UNKNOWN;
+    long startNodes = solver->nodes++;
+
+    // Make every move first, a move that wins right away needs no search
+    struct KABoard* children = solver->children + ply*solver->tileCount;
+    enum PlayerStatus (*childStatus)[4] = solver->childStatus + ply*solver->tileCount;
+    int* order = solver->order + ply*solver->tileCount;
+    int* explosions = solver->explosions + ply*solver->tileCount;
+    int moveCount = 0;
+    for(int i=0; i<solver->tileCount; i++)
+    {
+        if(board->owner[i] != NOOWNER && board->owner[i] != player)
+            continue;
+        gamelogic_copyBoard(&children[i], board);
+        memcpy(childStatus[i], playerStatus, sizeof(childStatus[i]));
+        explosions[i] = gamelogic_resolveMove(&children[i], childStatus[i], i % board->gridWidth, i / board->gridWidth, player);
+        if(gamelogic_updatePlayerStatus(&children[i], childStatus[i], player))
+        {
+            tbStoreResult(solver, key, TB_WIN, i, 1);
+            *move = i;
+            return TB_WIN;
+        }
+        // Moves with bigger chain reactions are searched first, they take the most tiles and end the game sooner
+        int j = moveCount++;
+        while(j > 0 && explosions[order[j-1]] < explosions[i])
+        {
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    bool proven = true;
+    for(int i=0; i<moveCount; i++)
+    {
+        int index = order[i];
+        int childMove;
+        enum TablebaseResult result = tbSolve(solver, ply+1, &children[index], childStatus[index], gamelogic_getNextPlayer(childStatus[index], player), &childMove);
+        if(result == TB_LOSS)
+        {
+            tbStoreResult(solver, key, TB_WIN, index, solver->nodes-startNodes);
+            *move = index;
+            return TB_WIN;
+        }
+        if(result == TB_UNKNOWN)
+        {
+            // Every later move has to be searched too to prove a loss, which can't happen anymore once the node limit ran out
+            proven = false;
+            if(solver->nodes >= solver->gen->params.nodeLimit)
+                break;
+        }
+    }
+    if(!proven)
+        return TB_UNKNOWN;
+    tbStoreResult(solver, key, TB_LOSS, 0, solver->nodes-startNodes);
+    return TB_LOSS;
+}
+
+/// @brief Play a game from the empty board until the board has the requested amount of atoms, the game starts with random moves and continues with shallow AI searches,
+/// so the positions are close to the ones reached in real games
+/// @param board Board to write the position to, allocated with the generator grid size
+/// @param playerStatus Player statuses to write
+/// @param player Player to move to write
+/// @param minAtoms Amount of atoms
+/// @param random Random number generator
+/// @return true on success, false if every playout ended the game too soon
+static bool tbRandomPosition(struct KABoard* board, enum PlayerStatus playerStatus[4], int* player, int minAtoms, KRandom* random)
+{
+    int tileCount = board->gridWidth*board->gridHeight;
+    struct AISearchParams searchParams = {TABLEBASE_PLAYOUT_DEPTH, 0, NULL, NULL, NULL};
+    for(int tries=0; tries<TABLEBASE_PLAYOUT_TRIES; tries++)
+    {
+        memset(board->owner, NOOWNER, tileCount);
+        memset(board->count, 0, tileCount*sizeof(uint32_t));
+        memset(board->playerAtoms, 0, sizeof(board->playerAtoms));
+        board->hash = 0;
+        playerStatus[0] = playerStatus[1] = PST_NOTSTARTED;
+        playerStatus[2] = playerStatus[3] = PST_NOTPRESENT;
+        *player = 0;
+        bool gameEnded = false;
+        for(int ply=0; !gameEnded && board->playerAtoms[0]+board->playerAtoms[1] < minAtoms; ply++)
+        {
+            int index;
+            struct AISearchResult result;
+            if(ply >= TABLEBASE_PLAYOUT_RANDOMPLIES && gamesearch_findMove(board, *player, playerStatus, NULL, 0, &searchParams, &result))
+            {
+                index = BOARD_INDEX(board,result.move.x,result.move.y);
+            }
+            else
+            {
+                do
+                {
+                    index = krandom_range(random, tileCount);
+                } while(board->owner[index] != NOOWNER && board->owner[index] != *player);
+            }
+            gamelogic_resolveMove(board, playerStatus, index % board->gridWidth, index / board->gridWidth, *player);
+            gameEnded = gamelogic_updatePlayerStatus(board, playerStatus, *player);
+            *player = gamelogic_getNextPlayer(playerStatus, *player);
+        }
+        if(!gameEnded)
+            return true;
+    }
+    return false;
+}
+
+/// @brief Solve random positions until every random position of the generator is taken (thread pool task)
+/// @param data Solver thread
+/// @param threadIndex Thread index (unused)
+static void tbSolveTask(void* data, int threadIndex)
+{
+    (void)threadIndex;
+    struct TablebaseSolver* solver = data;
+    const struct TablebaseParams* params = &solver->gen->params;
+    struct KABoard root;
+    if(!gamelogic_allocBoard(&root, params->gridWidth, params->gridHeight))
+    {
+        solver->failed = true;
+        return;
+    }
+    root.explosionMode = params->explosionMode;
+    int rootIndex;
+    while(!solver->failed && (rootIndex = SDL_AtomicAdd(&solver->gen->nextRoot, 1)) < params->rootCount)
+    {
+        // Every random position has its own generator, so the positions don't depend on the thread count
+        KRandom random;
+        krandom_seed(&random, params->seed+rootIndex);
+        enum PlayerStatus playerStatus[4];
+        int player;
+        if(!tbRandomPosition(&root, playerStatus, &player, params->minAtoms, &random))
+            continue;
+        int move;
+        solver->nodes = 0;
+        solver->results[tbSolve(solver, 0, &root, playerStatus, player, &move)]++;
+        solver->totalNodes += solver->nodes;
+    }
+    gamelogic_freeBoard(&root);
+}
+
+bool gametablebasegen_generate(const char* path, const struct TablebaseParams* params)
+{
+    struct TablebaseGenerator gen;
+    gen.params = *params;
+    if(gen.params.rootCount <= 0)
+        gen.params.rootCount = TABLEBASE_DEFAULT_ROOTS;
+    if(gen.params.minAtoms <= 0)
+        gen.params.minAtoms = TABLEBASE_DEFAULT_MINATOMS;
+    if(gen.params.nodeLimit <= 0)
+        gen.params.nodeLimit = TABLEBASE_DEFAULT_NODELIMIT;
+    if(gen.params.minProofNodes <= 0)
+        gen.params.minProofNodes = TABLEBASE_DEFAULT_MINPROOF;
+    int threadCount = (gen.params.threadCount > 0) ? gen.params.threadCount : SDL_GetCPUCount();
+    threadCount = SDL_clamp(threadCount, 1, KTHREADPOOL_MAX_THREADS);
+    SDL_AtomicSet(&gen.nextRoot, 0);
+    gen.table = gametranstable_create((size_t)TABLEBASE_TABLESIZE*1024*1024);
+
+    KThreadPool* threadPool = kthreadpool_create(threadCount);
+    struct TablebaseSolver* solvers = calloc(threadCount, sizeof(struct TablebaseSolver));
+    KTimer* timer = ktimer_create();
+    bool success = (gen.table && threadPool && solvers && timer);
+    for(int i=0; i<threadCount && success; i++)
+        success = tbInitSolver(&solvers[i], &gen);
+
+    long entryCount = -1;
+    if(success)
+    {
+        SDL_Log("Tablebase: %s %d x %d, %d positions with %d atoms, %ld nodes per position, %d threads",(gen.params.explosionMode == EXPLOSION_WAVE) ? "wave" : "sequential",
+            gen.params.gridWidth,gen.params.gridHeight,gen.params.rootCount,gen.params.minAtoms,gen.params.nodeLimit,threadCount);
+        // One task per thread, the tasks take random positions from a shared counter until every one is solved
+        for(int i=0; i<threadCount; i++)
+            kthreadpool_submit(threadPool, tbSolveTask, &solvers[i]);
+        kthreadpool_wait(threadPool);
+
+        long totalNodes = 0;
+        long totalEntries = 0;
+        int results[3] = {0};
+        for(int i=0; i<threadCount; i++)
+        {
+            success = success && !solvers[i].failed;
+            totalNodes += solvers[i].totalNodes;
+            totalEntries += solvers[i].entryCount;
+            for(int j=0; j<3; j++)
+                results[j] += solvers[i].results[j];
+        }
+        float seconds = ktimer_getTimeFloat(timer);
+        SDL_Log("Tablebase: %d won, %d lost, %d unknown, %ld nodes in %.1f s (%.0f nodes/s)",results[TB_WIN],results[TB_LOSS],results[TB_UNKNOWN],
+            totalNodes,seconds,totalNodes/SDL_max(seconds,0.001f));
+
+        // The thread entry lists are moved into the first one
+        struct TablebaseEntry* entries = success ? realloc(solvers[0].entries, SDL_max(totalEntries,1)*sizeof(struct TablebaseEntry)) : NULL;
+        if(entries)
+        {
+            solvers[0].entries = entries;
+            long offset = solvers[0].entryCount;
+            for(int i=1; i<threadCount; i++)
+            {
+                memcpy(entries+offset, solvers[i].entries, solvers[i].entryCount*sizeof(struct TablebaseEntry));
+                offset += solvers[i].entryCount;
+            }
+            entryCount = gametablebasegen_write(path, gen.params.gridWidth, gen.params.gridHeight, gen.params.explosionMode, entries, totalEntries);
+        }
+    }
+
+    if(entryCount >= 0)
+        SDL_Log("Tablebase: %ld positions written to %s",entryCount,path);
+    else
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametablebasegen_generate: Couldn't generate the tablebase %s!",path);
+    for(int i=0; solvers && i<threadCount; i++)
+        tbFreeSolver(&solvers[i]);
+    free(solvers);
+    ktimer_destroy(timer);
+    kthreadpool_destroy(threadPool);
+    gametranstable_free(gen.table);
+    return entryCount >= 0;
+}
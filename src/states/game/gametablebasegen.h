@@ -0,0 +1,53 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gametablebase.h"
+
+// Default amount of random positions solved by the generator
+#define TABLEBASE_DEFAULT_ROOTS 2000
+
+// Default amount of atoms on the board of every random position
+#define TABLEBASE_DEFAULT_MINATOMS 24
+
+// Default amount of positions the solver may visit for every random position before giving up on it
+#define TABLEBASE_DEFAULT_NODELIMIT 200000
+
+// Default amount of positions a proof has to visit for the position to be written, the AI search proves the others by itself
+#define TABLEBASE_DEFAULT_MINPROOF 256
+
+// Solved position written to a tablebase file
+struct TablebaseEntry {
+    uint64_t key;                   //Position key (see gametablebase_getKey)
+    uint16_t move;                  //Tile index of a winning move (only for TB_WIN)
+    enum TablebaseResult result;    //Position result
+};
+
+// Tablebase generator settings
+struct TablebaseParams {
+    int gridWidth;                      //Grid width (1-MAX_GRID_WIDTH)
+    int gridHeight;                     //Grid height (1-MAX_GRID_HEIGHT)
+    enum ExplosionMode explosionMode;   //Explosion mode of the positions
+    int rootCount;                      //Amount of random positions to solve (TABLEBASE_DEFAULT_ROOTS if <= 0)
+    int minAtoms;                       //Amount of atoms on the board of every random position (TABLEBASE_DEFAULT_MINATOMS if <= 0)
+    long nodeLimit;                     //Amount of positions the solver may visit for every random position (TABLEBASE_DEFAULT_NODELIMIT if <= 0)
+    long minProofNodes;                 //Amount of positions a proof has to visit for the position to be written (TABLEBASE_DEFAULT_MINPROOF if <= 0)
+    int threadCount;                    //Amount of solver threads (0 = one per CPU core)
+    uint64_t seed;                      //Seed of the random positions, the same seed always gives the same positions
+};
+
+/// @brief Sort solved positions and write them to a tablebase file, duplicate positions are written once
+/// @param path Output file path
+/// @param gridWidth Grid width of the positions
+/// @param gridHeight Grid height of the positions
+/// @param explosionMode Explosion mode of the positions
+/// @param entries Solved positions (sorted by this function)
+/// @param entryCount Amount of solved positions
+/// @return Amount of written entries or -1 if the file couldn't be written
+long gametablebasegen_write(const char* path, int gridWidth, int gridHeight, enum ExplosionMode explosionMode, struct TablebaseEntry* entries, long entryCount);
+
+/// @brief Generate a tablebase by solving random 2 player positions with an exhaustive win/loss search, the positions proven on the way that needed a big enough search are written to the tablebase.
+/// Positions the solver can't prove within the node limit are left out, so the tablebase only holds exact results.
+/// @param path Output file path
+/// @param params Generator settings
+/// @return true on success, false if the tablebase couldn't be generated or written
+bool gametablebasegen_generate(const char* path, const struct TablebaseParams* params);
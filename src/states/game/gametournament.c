@@ -0,0 +1,453 @@
+#include "gametournament.h"
+#include "gameai.h"
+#include "../../utils/random.h"
+#include "../../utils/threadpool.h"
+#include "../../utils/timer.h"
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Moves per grid tile after which a game is stopped and counted as a draw
+#define TOUR_MOVELIMIT 20
+
+// Winner of a game stopped by the move limit
+#define TOUR_DRAW -1
+
+// Virtual draws added between every pair of entrants, keeps the ratings finite when an entrant wins or loses every game
+#define TOUR_PRIORGAMES 1.0
+
+// Rating iterations and the rating change at which they stop early
+#define TOUR_RATINGITERATIONS 10000
+#define TOUR_RATINGEPSILON 1e-9
+
+// Z score of the 95% confidence interval
+#define TOUR_CONFIDENCE 1.96
+
+// Scheduled game of the tournament
+struct TourGame {
+    int gridWidth;
+    int gridHeight;
+    int seatCount;          //Amount of players, they play as players 1 to seatCount
+    int entrants[4];        //Entrant index of every seat
+    int winner;             //Seat of the winner or TOUR_DRAW (written by the thread that played the game)
+    int moves;              //Amount of moves made in the game
+    long explosions;        //Amount of tiles blown up in the game
+};
+
+// Tournament state shared by every thread
+struct TourState {
+    const struct TournamentParams* params;
+    struct TourGame* games;
+    int gameCount;
+    SDL_atomic_t nextGame;      //Next game to play
+    SDL_atomic_t finishedGames; //Amount of finished games, used for the progress log
+    SDL_atomic_t failed;        //Set to 1 if a game couldn't be played, the threads stop then
+};
+
+// Tournament thread
+struct TourWorker {
+    struct TourState* state;
+    struct AIContext* context;
+};
+
+/// @brief Play a scheduled game, every player is an AI with the difficulty of its entrant
+/// @param worker Tournament thread
+/// @param game Scheduled game to play and write the result to
+/// @param seed Seed of the game
+/// @return true on success, false if an AI couldn't find a move
+static bool tourPlayGame(struct TourWorker* worker, struct TourGame* game, uint64_t seed)
+{
+    const struct TournamentParams* params = worker->state->params;
+    struct KABoard board;
+    if(!gamelogic_allocBoard(&board, game->gridWidth, game->gridHeight))
+        return false;
+    board.explosionMode = params->explosionMode;
+    KRandom random;
+    krandom_seed(&random, seed);
+    enum PlayerStatus playerStatus[4];
+    for(int p=0; p<4; p++)
+        playerStatus[p] = (p < game->seatCount) ? PST_NOTSTARTED : PST_NOTPRESENT;
+
+    int player = 0;
+    int moveLimit = TOUR_MOVELIMIT*game->gridWidth*game->gridHeight;
+    bool success = true;
+    game->winner = TOUR_DRAW;
+    game->moves = 0;
+    game->explosions = 0;
+    while(game->moves < moveLimit)
+    {
+        Vec2 move;
+        int difficulty = params->entrants[game->entrants[player]];
+        if(!ai_findMove(worker->context, &board, playerStatus, player, difficulty, &random, &move))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametournament_run: AI %d couldn't find a move on a %d x %d grid!",difficulty,game->gridWidth,game->gridHeight);
+            success = false;
+            break;
+        }
+        int explosions = gamelogic_resolveMove(&board, playerStatus, move.x, move.y, player);
+        if(explosions < 0)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametournament_run: AI %d made an invalid move on a %d x %d grid!",difficulty,game->gridWidth,game->gridHeight);
+            success = false;
+            break;
+        }
+        game->explosions += explosions;
+        game->moves++;
+        if(gamelogic_updatePlayerStatus(&board, playerStatus, player))
+        {
+            game->winner = player;
+            break;
+        }
+        player = gamelogic_getNextPlayer(playerStatus, player);
+    }
+    gamelogic_freeBoard(&board);
+    return success;
+}
+
+/// @brief Play games until every game of the tournament is taken (thread pool task)
+/// @param data Tournament thread
+/// @param threadIndex Thread index (unused)
+static void tourPlayTask(void* data, int threadIndex)
+{
+    (void)threadIndex;
+    struct TourWorker* worker = data;
+    struct TourState* state = worker->state;
+    int gameIndex;
+    while(!SDL_AtomicGet(&state->failed) && (gameIndex = SDL_AtomicAdd(&state->nextGame, 1)) < state->gameCount)
+    {
+        if(!tourPlayGame(worker, &state->games[gameIndex], state->params->seed+gameIndex))
+        {
+            SDL_AtomicSet(&state->failed, 1);
+            break;
+        }
+        int finished = SDL_AtomicAdd(&state->finishedGames, 1)+1;
+        if(finished*10/state->gameCount != (finished-1)*10/state->gameCount)
+            SDL_Log("Tournament: %d of %d games played",finished,state->gameCount);
+    }
+}
+
+/// @brief Schedule every game of the tournament, or only count them
+/// @param params Tournament settings
+/// @param games Games to write (NULL = only count them)
+/// @return Amount of games
+static int tourSchedule(const struct TournamentParams* params, struct TourGame* games)
+{
+    int gameCount = 0;
+    int maxSeats = SDL_min(params->maxSeats, params->entrantCount);
+    for(int round=0; round<params->rounds; round++)
+    {
+        // The biggest grids have the longest games, they're played first so the threads finish at about the same time
+        for(int gridWidth=params->maxWidth; gridWidth>=params->minWidth; gridWidth--)
+        {
+            for(int gridHeight=params->maxHeight; gridHeight>=params->minHeight; gridHeight--)
+            {
+                for(int seatCount=params->minSeats; seatCount<=maxSeats; seatCount++)
+                {
+                    // Every combination of seatCount entrants in increasing index order
+                    int combination[4];
+                    for(int i=0; i<seatCount; i++)
+                        combination[i] = i;
+                    while(true)
+                    {
+                        // Every rotation of the seats, so every entrant of the match moves first once
+                        for(int rotation=0; rotation<seatCount; rotation++)
+                        {
+                            if(games)
+                            {
+                                struct TourGame* game = &games[gameCount];
+                                game->gridWidth = gridWidth;
+                                game->gridHeight = gridHeight;
+                                game->seatCount = seatCount;
+                                for(int seat=0; seat<seatCount; seat++)
+                                    game->entrants[seat] = combination[(seat+rotation) % seatCount];
+                            }
+                            gameCount++;
+                        }
+                        int i = seatCount-1;
+                        while(i >= 0 && combination[i] == params->entrantCount-seatCount+i)
+                            i--;
+                        if(i < 0)
+                            break;
+                        combination[i]++;
+                        for(int j=i+1; j<seatCount; j++)
+                            combination[j] = combination[j-1]+1;
+                    }
+                }
+            }
+        }
+    }
+    return gameCount;
+}
+
+/// @brief Invert a small symmetric positive definite matrix with Gauss-Jordan elimination
+/// @param matrix Matrix to invert in place (size x size values, row by row)
+/// @param size Matrix size (at most TOURNAMENT_MAX_ENTRANTS)
+/// @return true on success, false if the matrix is singular
+static bool tourInvertMatrix(double* matrix, int size)
+{
+    double inverse[TOURNAMENT_MAX_ENTRANTS*TOURNAMENT_MAX_ENTRANTS];
+    for(int i=0; i<size; i++)
+    {
+        for(int j=0; j<size; j++)
+            inverse[i*size+j] = (i == j);
+    }
+    for(int col=0; col<size; col++)
+    {
+        int pivot = col;
+        for(int row=col+1; row<size; row++)
+        {
+            if(fabs(matrix[row*size+col]) > fabs(matrix[pivot*size+col]))
+                pivot = row;
+        }
+        if(fabs(matrix[pivot*size+col]) < 1e-12)
+            return false;
+        for(int j=0; j<size; j++)
+        {
+            double temp = matrix[col*size+j];
+            matrix[col*size+j] = matrix[pivot*size+j];
+            matrix[pivot*size+j] = temp;
+            temp = inverse[col*size+j];
+            inverse[col*size+j] = inverse[pivot*size+j];
+            inverse[pivot*size+j] = temp;
+        }
+        double scale = matrix[col*size+col];
+        for(int j=0; j<size; j++)
+        {
+            matrix[col*size+j] /= scale;
+            inverse[col*size+j] /= scale;
+        }
+        for(int row=0; row<size; row++)
+        {
+            double factor = matrix[row*size+col];
+            if(row == col || factor == 0)
+                continue;
+            for(int j=0; j<size; j++)
+            {
+                matrix[row*size+j] -= factor*matrix[col*size+j];
+                inverse[row*size+j] -= factor*inverse[col*size+j];
+            }
+        }
+    }
+    memcpy(matrix, inverse, size*size*sizeof(double));
+    return true;
+}
+
+/// @brief Fit Bradley-Terry ratings to the pairwise results with the MM algorithm and get their confidence intervals from the Fisher information
+/// @param entrantCount Amount of entrants
+/// @param score Score of every entrant against every other entrant (a win is 1 and a draw is 0.5)
+/// @param games Amount of pairwise results of every entrant against every other entrant
+/// @param elo Elo rating of every entrant to write, the first entrant is rated 0
+/// @param error Half width of the 95% confidence interval of every rating to write
+static void tourGetRatings(int entrantCount, double score[][TOURNAMENT_MAX_ENTRANTS], double games[][TOURNAMENT_MAX_ENTRANTS], double* elo, double* error)
+{
+    double strength[TOURNAMENT_MAX_ENTRANTS];
+    for(int i=0; i<entrantCount; i++)
+        strength[i] = 1.0;
+    for(int iteration=0; iteration<TOUR_RATINGITERATIONS; iteration++)
+    {
+        double maxChange = 0;
+        for(int i=0; i<entrantCount; i++)
+        {
+            double wins = 0;
+            double weight = 0;
+            for(int j=0; j<entrantCount; j++)
+            {
+                if(j == i)
+                    continue;
+                wins += score[i][j] + TOUR_PRIORGAMES/2;
+                weight += (games[i][j] + TOUR_PRIORGAMES)/(strength[i]+strength[j]);
+            }
+            double newStrength = wins/weight;
+            maxChange = SDL_max(maxChange, fabs(log(newStrength/strength[i])));
+            strength[i] = newStrength;
+        }
+        for(int i=entrantCount-1; i>=0; i--)
+            strength[i] /= strength[0];
+        if(maxChange < TOUR_RATINGEPSILON)
+            break;
+    }
+
+    // The first rating is fixed, so the covariance of the others is the inverse of their Fisher information (in natural log units)
+    int size = entrantCount-1;
+    double information[TOURNAMENT_MAX_ENTRANTS*TOURNAMENT_MAX_ENTRANTS] = {0};
+    for(int i=1; i<entrantCount; i++)
+    {
+        for(int j=0; j<entrantCount; j++)
+        {
+            if(j == i)
+                continue;
+            double p = strength[i]/(strength[i]+strength[j]);
+            double variance = (games[i][j] + TOUR_PRIORGAMES)*p*(1-p);
+            information[(i-1)*size+(i-1)] += variance;
+            if(j > 0)
+                information[(i-1)*size+(j-1)] -= variance;
+        }
+    }
+    bool inverted = tourInvertMatrix(information, size);
+    elo[0] = 0;
+    error[0] = 0;
+    for(int i=1; i<entrantCount; i++)
+    {
+        elo[i] = 400.0*log10(strength[i]);
+        error[i] = inverted ? TOUR_CONFIDENCE*sqrt(information[(i-1)*size+(i-1)])*400.0/log(10.0) : INFINITY;
+    }
+}
+
+/// @brief Log the results of the played tournament games
+/// @param state Tournament state
+/// @param seconds Time the games took in seconds
+/// @param threadCount Amount of threads the games were played on
+static void tourLogResults(const struct TourState* state, float seconds, int threadCount)
+{
+    const struct TournamentParams* params = state->params;
+    int entrantCount = params->entrantCount;
+    long entrantGames[TOURNAMENT_MAX_ENTRANTS] = {0};
+    long entrantWins[TOURNAMENT_MAX_ENTRANTS] = {0};
+    double entrantExpected[TOURNAMENT_MAX_ENTRANTS] = {0};
+    double score[TOURNAMENT_MAX_ENTRANTS][TOURNAMENT_MAX_ENTRANTS] = {{0}};
+    double games[TOURNAMENT_MAX_ENTRANTS][TOURNAMENT_MAX_ENTRANTS] = {{0}};
+    long seatGames[5] = {0};
+    long seatMoves[5] = {0};
+    long seatWins[5][4] = {{0}};
+    long totalMoves = 0;
+    long totalExplosions = 0;
+    long draws = 0;
+    for(int g=0; g<state->gameCount; g++)
+    {
+        const struct TourGame* game = &state->games[g];
+        totalMoves += game->moves;
+        totalExplosions += game->explosions;
+        seatGames[game->seatCount]++;
+        seatMoves[game->seatCount] += game->moves;
+        if(game->winner == TOUR_DRAW)
+            draws++;
+        else
+            seatWins[game->seatCount][game->winner]++;
+        for(int a=0; a<game->seatCount; a++)
+        {
+            int entrant = game->entrants[a];
+            entrantGames[entrant]++;
+            entrantExpected[entrant] += 1.0/game->seatCount;
+            if(game->winner == a)
+                entrantWins[entrant]++;
+            // Every seat pair with a winner in it (or a draw) is a pairwise result, two players who both lost a 3 or 4 player game aren't compared
+            for(int b=0; b<game->seatCount; b++)
+            {
+                if(b == a || (game->winner != a && game->winner != b && game->winner != TOUR_DRAW))
+                    continue;
+                score[entrant][game->entrants[b]] += (game->winner == a) ? 1.0 : (game->winner == TOUR_DRAW) ? 0.5 : 0.0;
+                games[entrant][game->entrants[b]] += 1.0;
+            }
+        }
+    }
+
+    double elo[TOURNAMENT_MAX_ENTRANTS];
+    double error[TOURNAMENT_MAX_ENTRANTS];
+    tourGetRatings(entrantCount, score, games, elo, error);
+
+    seconds = SDL_max(seconds, 0.001f);
+    SDL_Log("Tournament: %d games in %.1f s on %d threads, %.1f moves per game, %ld draws by the move limit",state->gameCount,seconds,threadCount,
+        (double)totalMoves/state->gameCount,draws);
+    SDL_Log("Throughput: %.1f games/s, %.0f moves/s, %.0f explosions/s",state->gameCount/seconds,totalMoves/seconds,totalExplosions/seconds);
+    SDL_Log("Entrant  AI  Games    Wins  Win rate  Expected       Elo");
+    for(int i=0; i<entrantCount; i++)
+    {
+        SDL_Log("%7d  %2d  %5ld  %6ld  %7.1f%%  %7.1f%%  %+5.0f +- %.0f",i+1,params->entrants[i],entrantGames[i],entrantWins[i],
+            100.0*entrantWins[i]/SDL_max(entrantGames[i],1),100.0*entrantExpected[i]/SDL_max(entrantGames[i],1),elo[i],error[i]);
+    }
+
+    SDL_Log("Pairwise score of the row entrant against the column entrant (results):");
+    for(int i=0; i<entrantCount; i++)
+    {
+        char line[TOURNAMENT_MAX_ENTRANTS*20+16];
+        int length = SDL_snprintf(line, sizeof(line), "%7d ", i+1);
+        for(int j=0; j<entrantCount; j++)
+        {
+            if(j == i)
+                length += SDL_snprintf(line+length, sizeof(line)-length, "  %17s", "-");
+            else
+                length += SDL_snprintf(line+length, sizeof(line)-length, "  %6.1f%% (%7.0f)", 100.0*score[i][j]/SDL_max(games[i][j],1.0), games[i][j]);
+        }
+        SDL_Log("%s",line);
+    }
+
+    for(int seatCount=2; seatCount<=4; seatCount++)
+    {
+        if(seatGames[seatCount] == 0)
+            continue;
+        char line[64];
+        int length = 0;
+        for(int seat=0; seat<seatCount; seat++)
+            length += SDL_snprintf(line+length, sizeof(line)-length, " %.1f%%", 100.0*seatWins[seatCount][seat]/seatGames[seatCount]);
+        SDL_Log("%d players: %ld games, %.1f moves per game, win rate of every seat in turn order:%s",seatCount,seatGames[seatCount],
+            (double)seatMoves[seatCount]/seatGames[seatCount],line);
+    }
+}
+
+bool gametournament_run(const struct TournamentParams* params)
+{
+    struct TournamentParams checkedParams = *params;
+    if(checkedParams.rounds <= 0)
+        checkedParams.rounds = TOURNAMENT_DEFAULT_ROUNDS;
+    bool valid = (checkedParams.entrantCount >= 2 && checkedParams.entrantCount <= TOURNAMENT_MAX_ENTRANTS);
+    for(int i=0; i<checkedParams.entrantCount && valid; i++)
+        valid = (checkedParams.entrants[i] >= 1 && checkedParams.entrants[i] <= 5);
+    valid = valid && checkedParams.minSeats >= 2 && checkedParams.minSeats <= checkedParams.maxSeats && checkedParams.maxSeats <= 4
+        && checkedParams.minSeats <= checkedParams.entrantCount
+        && checkedParams.minWidth >= 1 && checkedParams.minWidth <= checkedParams.maxWidth && checkedParams.maxWidth <= MAX_GRID_WIDTH
+        && checkedParams.minHeight >= 1 && checkedParams.minHeight <= checkedParams.maxHeight && checkedParams.maxHeight <= MAX_GRID_HEIGHT;
+    if(!valid)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametournament_run: Invalid tournament settings!");
+        return false;
+    }
+
+    struct TourState state;
+    state.params = &checkedParams;
+    state.gameCount = tourSchedule(&checkedParams, NULL);
+    state.games = calloc(state.gameCount, sizeof(struct TourGame));
+    SDL_AtomicSet(&state.nextGame, 0);
+    SDL_AtomicSet(&state.finishedGames, 0);
+    SDL_AtomicSet(&state.failed, 0);
+    int threadCount = (checkedParams.threadCount > 0) ? checkedParams.threadCount : SDL_GetCPUCount();
+    threadCount = SDL_clamp(threadCount, 1, KTHREADPOOL_MAX_THREADS);
+
+    KThreadPool* threadPool = kthreadpool_create(threadCount);
+    struct TourWorker* workers = calloc(threadCount, sizeof(struct TourWorker));
+    KTimer* timer = ktimer_create();
+    bool success = (state.games && threadPool && workers && timer);
+    for(int i=0; i<threadCount && success; i++)
+    {
+        workers[i].state = &state;
+        workers[i].context = ai_createContext(checkedParams.tableSize);
+        success = (workers[i].context != NULL);
+    }
+
+    if(success)
+    {
+        tourSchedule(&checkedParams, state.games);
+        SDL_Log("Tournament: %d entrants, %d games, %d x %d to %d x %d grids, %d-%d players, %d threads",checkedParams.entrantCount,state.gameCount,
+            checkedParams.minWidth,checkedParams.minHeight,checkedParams.maxWidth,checkedParams.maxHeight,checkedParams.minSeats,
+            SDL_min(checkedParams.maxSeats,checkedParams.entrantCount),threadCount);
+        // One task per thread, the tasks take games from a shared counter until every game is played
+        for(int i=0; i<threadCount; i++)
+            kthreadpool_submit(threadPool, tourPlayTask, &workers[i]);
+        kthreadpool_wait(threadPool);
+        success = !SDL_AtomicGet(&state.failed);
+        if(success)
+            tourLogResults(&state, ktimer_getTimeFloat(timer), threadCount);
+    }
+    else
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametournament_run: Couldn't allocate the tournament data!");
+    }
+
+    for(int i=0; workers && i<threadCount; i++)
+        ai_freeContext(workers[i].context);
+    free(workers);
+    free(state.games);
+    ktimer_destroy(timer);
+    kthreadpool_destroy(threadPool);
+    return success;
+}
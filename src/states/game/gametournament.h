@@ -0,0 +1,39 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gamelogic.h"
+
+// Max amount of AI players taking part in a tournament
+#define TOURNAMENT_MAX_ENTRANTS 8
+
+// Default amount of times every match is played
+#define TOURNAMENT_DEFAULT_ROUNDS 1
+
+// Default transposition table size of every tournament thread in megabytes (only used by the difficulty 4 AI)
+#define TOURNAMENT_DEFAULT_TABLESIZE 16
+
+// Tournament settings
+struct TournamentParams {
+    int entrants[TOURNAMENT_MAX_ENTRANTS];  //AI difficulty of every entrant (1-5)
+    int entrantCount;                       //Amount of entrants (2-TOURNAMENT_MAX_ENTRANTS)
+    int minSeats;                           //Smallest amount of players in a game (2-4)
+    int maxSeats;                           //Largest amount of players in a game (minSeats-4, limited to entrantCount)
+    int minWidth;                           //Grid sizes the matches are played on, every size from min to max
+    int maxWidth;
+    int minHeight;
+    int maxHeight;
+    enum ExplosionMode explosionMode;       //Chain reaction propagation mode of every game
+    int rounds;                             //Times every match is played (TOURNAMENT_DEFAULT_ROUNDS if <= 0)
+    int threadCount;                        //Amount of threads playing games (0 = one per CPU core)
+    int tableSize;                          //Transposition table size of every thread in megabytes (0 = no table)
+    uint64_t seed;                          //Seed of the first game, every next game adds 1 to it
+};
+
+/// @brief Play a round-robin AI tournament and log the results.
+/// Every combination of entrants for every seat count is played on every grid size with the seats rotated, so every entrant plays every seat once.
+/// The games are taken from a shared queue by every thread, the AI searches of a game run on its thread only (see ai_findMove).
+/// The log has the win rate and Elo rating (with a 95% confidence interval, the first entrant is rated 0) of every entrant,
+/// the pairwise scores, the win rate of every seat, the average game length and the games, moves and explosions per second.
+/// @param params Tournament settings
+/// @return true on success, false if the settings are invalid or the allocation failed
+bool gametournament_run(const struct TournamentParams* params);
@@ -0,0 +1,142 @@
+#include "gametranstable.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Stored search result packed into 12 bytes
+struct TransSlot {
+    uint32_t check;     //Upper 32 bits of the position key (the lower bits select the bucket)
+    int32_t score;      //Position score
+    uint32_t data;      //Move + 1 (bits 0-16), depth (bits 17-21), bound (bits 22-23) and search generation (bits 24-31), 0 for an empty slot
+};
+
+// A single cache line of slots
+struct TransBucket {
+    SDL_SpinLock lock;
+    struct TransSlot slots[TRANSTABLE_BUCKET_ENTRIES];
+};
+
+SDL_COMPILE_TIME_ASSERT(transBucketSize, sizeof(struct TransBucket) == TRANSTABLE_BUCKET_SIZE);
+
+struct TransTable {
+    struct TransBucket* buckets;    //Buckets aligned to TRANSTABLE_BUCKET_SIZE
+    void* memory;                   //Allocation the buckets are placed in
+    uint64_t bucketMask;            //Bucket count - 1
+    uint8_t generation;             //Current search generation
+};
+
+#define SLOT_MOVE(data) ((int)((data) & 0x1FFFF) - 1)
+#define SLOT_DEPTH(data) ((int)(((data) >> 17) & 0x1F))
+#define SLOT_BOUND(data) ((enum TransBound)(((data) >> 22) & 0x3))
+#define SLOT_GENERATION(data) ((uint8_t)((data) >> 24))
+// Amount of searches since the slot was stored (0 = stored by the current search)
+#define SLOT_AGE(table,data) ((uint8_t)((table)->generation - SLOT_GENERATION(data)))
+
+struct TransTable* gametranstable_create(size_t sizeBytes)
+{
+    struct TransTable* table = calloc(1,sizeof(struct TransTable));
+    if(!table)
+        return NULL;
+    uint64_t bucketCount = 1;
+    while(bucketCount*2*TRANSTABLE_BUCKET_SIZE <= sizeBytes)
+        bucketCount *= 2;
+
+    // malloc only guarantees the alignment of the basic types, so the buckets are aligned by hand
+    table->memory = malloc(bucketCount*TRANSTABLE_BUCKET_SIZE + TRANSTABLE_BUCKET_SIZE-1);
+    if(!table->memory)
+    {
+        free(table);
+        return NULL;
+    }
+    uintptr_t address = ((uintptr_t)table->memory + TRANSTABLE_BUCKET_SIZE-1) & ~(uintptr_t)(TRANSTABLE_BUCKET_SIZE-1);
+    table->buckets = (struct TransBucket*)address;
+    table->bucketMask = bucketCount-1;
+    gametranstable_clear(table);
+    return table;
+}
+
+void gametranstable_free(struct TransTable* table)
+{
+    if(!table)
+        return;
+    free(table->memory);
+    free(table);
+}
+
+void gametranstable_clear(struct TransTable* table)
+{
+    memset(table->buckets, 0, (table->bucketMask+1)*sizeof(struct TransBucket));
+    table->generation = 0;
+}
+
+void gametranstable_newSearch(struct TransTable* table)
+{
+    // Slot ages are counted in 8 bits, so the table is cleared before the generation comes around again and old slots would look current
+    if(++table->generation == 0)
+        gametranstable_clear(table);
+}
+
+bool gametranstable_probe(struct TransTable* table, uint64_t key, struct TransEntry* entry)
+{
+    struct TransBucket* bucket = &table->buckets[key & table->bucketMask];
+    uint32_t check = (uint32_t)(key >> 32);
+    bool found = false;
+    SDL_AtomicLock(&bucket->lock);
+    for(int i=0; i<TRANSTABLE_BUCKET_ENTRIES; i++)
+    {
+        const struct TransSlot* slot = &bucket->slots[i];
+        if(slot->data != 0 && slot->check == check)
+        {
+            entry->score = slot->score;
+            entry->move = SLOT_MOVE(slot->data);
+            entry->depth = SLOT_DEPTH(slot->data);
+            entry->bound = SLOT_BOUND(slot->data);
+            found = true;
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&bucket->lock);
+    return found;
+}
+
+void gametranstable_store(struct TransTable* table, uint64_t key, const struct TransEntry* entry)
+{
+    struct TransBucket* bucket = &table->buckets[key & table->bucketMask];
+    uint32_t check = (uint32_t)(key >> 32);
+    uint32_t data = (uint32_t)((entry->move+1) & 0x1FFFF) | ((uint32_t)SDL_clamp(entry->depth,1,31) << 17)
+        | ((uint32_t)entry->bound << 22) | ((uint32_t)table->generation << 24);
+    SDL_AtomicLock(&bucket->lock);
+
+    // The same position is kept if it was searched deeper during this search, otherwise the emptiest or oldest slot is replaced:
+    // the oldest slots go first, then the ones with the lowest depth
+    struct TransSlot* target = NULL;
+    int targetValue = INT32_MAX;
+    for(int i=0; i<TRANSTABLE_BUCKET_ENTRIES; i++)
+    {
+        struct TransSlot* slot = &bucket->slots[i];
+        if(slot->data != 0 && slot->check == check)
+        {
+            bool keep = (SLOT_AGE(table,slot->data) == 0 && SLOT_DEPTH(slot->data) > entry->depth && entry->bound != TRANS_EXACT);
+            target = keep ? NULL : slot;
+            break;
+        }
+        int value = (slot->data == 0) ? -1 : (UINT8_MAX-SLOT_AGE(table,slot->data))*32 + SLOT_DEPTH(slot->data);
+        if(value < targetValue)
+        {
+            target = slot;
+            targetValue = value;
+        }
+    }
+    if(target)
+    {
+        target->check = check;
+        target->score = entry->score;
+        target->data = data;
+    }
+    SDL_AtomicUnlock(&bucket->lock);
+}
+
+size_t gametranstable_getSize(const struct TransTable* table)
+{
+    return (table->bucketMask+1)*sizeof(struct TransBucket);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of a transposition table bucket in bytes (a single cache line)
+#define TRANSTABLE_BUCKET_SIZE 64
+
+// Amount of entries in a bucket
+#define TRANSTABLE_BUCKET_ENTRIES 5
+
+// How a stored score relates to the real position score
+enum TransBound {
+    TRANS_EXACT,    //The score is exact
+    TRANS_LOWER,    //The real score is at least the stored score (the search failed high)
+    TRANS_UPPER     //The real score is at most the stored score (the search failed low)
+};
+
+// Search result stored for a position
+struct TransEntry {
+    int score;              //Position score
+    int move;               //Tile index of the best move or -1
+    int depth;              //Remaining search depth the score was found with
+    enum TransBound bound;  //Score bound type
+};
+
+// Fixed-size hash table of search results, shared by every search thread and kept between searches.
+// Every bucket is a single cache line guarded by its own spinlock.
+struct TransTable;
+
+/// @brief Create a transposition table
+/// @param sizeBytes Memory budget, the table uses the largest power of two bucket count that fits in it (at least one bucket)
+/// @return Transposition table or NULL on allocation failure
+struct TransTable* gametranstable_create(size_t sizeBytes);
+
+/// @brief Free a transposition table
+/// @param table Transposition table (can be NULL)
+void gametranstable_free(struct TransTable* table);
+
+/// @brief Remove every stored position
+/// @param table Transposition table
+void gametranstable_clear(struct TransTable* table);
+
+/// @brief Start a new search, positions stored by older searches are replaced first (the table is cleared every 256 searches, when the 8-bit search generation wraps around)
+/// @param table Transposition table
+void gametranstable_newSearch(struct TransTable* table);
+
+/// @brief Look a position up
+/// @param table Transposition table
+/// @param key Position key
+/// @param entry Entry to write the stored result to
+/// @return true if the position was found
+bool gametranstable_probe(struct TransTable* table, uint64_t key, struct TransEntry* entry);
+
+/// @brief Store a search result, replacing the entry of the same position or the least useful entry of the bucket
+/// @param table Transposition table
+/// @param key Position key
+/// @param entry Search result (depth has to be 1-31)
+void gametranstable_store(struct TransTable* table, uint64_t key, const struct TransEntry* entry);
+
+/// @brief Get the memory used by the table entries
+/// @param table Transposition table
+/// @return Size in bytes
+size_t gametranstable_getSize(const struct TransTable* table);
@@ -0,0 +1,455 @@
+#include "gametune.h"
+#include "../../game/game.h"
+#include "../../utils/random.h"
+#include "../../utils/threadpool.h"
+#include "../../utils/timer.h"
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the positions file header (magic number, version and feature count)
+#define TUNE_HEADER_SIZE 8
+
+// Size of a positions file record (features, result and padding)
+#define TUNE_RECORD_SIZE (2*EVAL_FEATURE_COUNT+2)
+
+// Amount of random moves at the start of every game, the positions before them aren't recorded
+#define TUNE_RANDOMPLIES 4
+
+// Chance of a random move after the start of the game in percent
+#define TUNE_RANDOMMOVES 10
+
+// Amount of games a thread takes at once
+#define TUNE_GAMEBATCH 16
+
+// Amount of records a thread collects before writing them to the file
+#define TUNE_WRITEBUFFER 16384
+
+// Score in weight units that predicts a 73% chance of winning (logistic function input of 1)
+#define TUNE_SIGMOID_SCALE (16.0f*EVAL_WEIGHT_SCALE)
+
+// Adam moment decay rates
+#define TUNE_ADAM_BETA1 0.9
+#define TUNE_ADAM_BETA2 0.999
+
+// Feature names used in the log
+static const char* tuneFeatureNames[EVAL_FEATURE_COUNT] = {
+    "atoms", "mobility", "safe corners", "safe sides", "safe pre-critical", "corner threats", "side threats", "center threats", "advantage"
+};
+
+// Self-play state shared by every thread
+struct TuneGenerator {
+    struct TuneGameParams params;
+    SDL_RWops* file;            //Positions file
+    SDL_mutex* fileLock;        //Guards the positions file
+    SDL_atomic_t nextGame;      //Next game to play
+};
+
+// Self-play state of a single thread
+struct TuneWorker {
+    struct TuneGenerator* gen;
+    uint8_t* buffer;                                //Records waiting to be written
+    int bufferCount;
+    int16_t (*gameRecords)[EVAL_FEATURE_COUNT];     //Features of every recorded position of the current game
+    int* gameMovers;                                //Player to move of every recorded position
+    long gameCount;
+    long positionCount;
+    bool failed;
+};
+
+/// @brief Write the buffered records of a thread to the positions file
+/// @param worker Self-play thread
+static void tuneFlush(struct TuneWorker* worker)
+{
+    if(worker->bufferCount == 0)
+        return;
+    SDL_LockMutex(worker->gen->fileLock);
+    if(SDL_RWwrite(worker->gen->file, worker->buffer, TUNE_RECORD_SIZE, worker->bufferCount) != (size_t)worker->bufferCount)
+        worker->failed = true;
+    SDL_UnlockMutex(worker->gen->fileLock);
+    worker->bufferCount = 0;
+}
+
+/// @brief Pick the move with the best evaluation after it, a winning move is picked right away
+/// @param weights Evaluation weights
+/// @param board Board of the position
+/// @param playerStatus Player statuses of the position
+/// @param player Player to move
+/// @param child Board to make the moves on, allocated with the same size as board
+/// @param random Random number generator used to pick between equally good moves
+/// @return Tile index of the move
+static int tuneGreedyMove(const struct EvalWeights* weights, const struct KABoard* board, const enum PlayerStatus playerStatus[4], int player, struct KABoard* child, KRandom* random)
+{
+    int bestMove = -1;
+    int bestScore = 0;
+    int bestCount = 0;
+    for(int i=0; i<board->gridWidth*board->gridHeight; i++)
+    {
+        if(board->owner[i] != NOOWNER && board->owner[i] != player)
+            continue;
+        enum PlayerStatus childStatus[4];
+        memcpy(childStatus, playerStatus, sizeof(childStatus));
+        gamelogic_copyBoard(child, board);
+        gamelogic_resolveMove(child, childStatus, i % board->gridWidth, i / board->gridWidth, player);
+        if(gamelogic_updatePlayerStatus(child, childStatus, player))
+            return i;
+        int score = gameeval_evaluate(weights, child, childStatus, player);
+        if(bestMove < 0 || score > bestScore)
+        {
+            bestMove = i;
+            bestScore = score;
+            bestCount = 1;
+        }
+        else if(score == bestScore && krandom_range(random, ++bestCount) == 0)
+        {
+            bestMove = i;
+        }
+    }
+    return bestMove;
+}
+
+/// @brief Play a self-play game and add its positions to the thread buffer
+/// @param worker Self-play thread
+/// @param gameIndex Game number, the game only depends on it and the seed
+/// @return true on success, false on allocation failure
+static bool tunePlayGame(struct TuneWorker* worker, int gameIndex)
+{
+    const struct TuneGameParams* params = &worker->gen->params;
+    KRandom random;
+    krandom_seed(&random, params->seed+gameIndex);
+    int gridWidth = MIN_GRIDWIDTH+krandom_range(&random, MAX_GRIDWIDTH-MIN_GRIDWIDTH+1);
+    int gridHeight = MIN_GRIDHEIGHT+krandom_range(&random, MAX_GRIDHEIGHT-MIN_GRIDHEIGHT+1);
+    int tileCount = gridWidth*gridHeight;
+    struct KABoard board;
+    struct KABoard child;
+    if(!gamelogic_allocBoard(&board, gridWidth, gridHeight))
+        return false;
+    if(!gamelogic_allocBoard(&child, gridWidth, gridHeight))
+    {
+        gamelogic_freeBoard(&board);
+        return false;
+    }
+    board.explosionMode = krandom_range(&random, 2) ? EXPLOSION_WAVE : EXPLOSION_SEQUENTIAL;
+    child.explosionMode = board.explosionMode;
+
+    // Every move adds an atom and a position that isn't won never has more than 3 atoms on a tile, so no game is longer than 3*tileCount+1 moves
+    enum PlayerStatus playerStatus[4] = {PST_NOTSTARTED, PST_NOTSTARTED, PST_NOTPRESENT, PST_NOTPRESENT};
+    int player = 0;
+    int winner = NOPLAYER;
+    int recordCount = 0;
+    for(int ply=0; winner == NOPLAYER; ply++)
+    {
+        bool randomStart = (ply < TUNE_RANDOMPLIES);
+        if(!randomStart && playerStatus[0] == PST_PLAYING && playerStatus[1] == PST_PLAYING && recordCount < 3*MAX_GRIDWIDTH*MAX_GRIDHEIGHT+2)
+        {
+            int features[4][EVAL_FEATURE_COUNT];
+            gameeval_getFeatures(&board, features);
+            for(int i=0; i<EVAL_FEATURE_COUNT; i++)
+                worker->gameRecords[recordCount][i] = SDL_clamp(features[player][i]-features[1-player][i], INT16_MIN, INT16_MAX);
+            worker->gameMovers[recordCount++] = player;
+        }
+        int move = -1;
+        if(!randomStart && krandom_range(&random, 100) >= TUNE_RANDOMMOVES)
+            move = tuneGreedyMove(params->weights, &board, playerStatus, player, &child, &random);
+        while(move < 0 || (board.owner[move] != NOOWNER && board.owner[move] != player))
+            move = krandom_range(&random, tileCount);
+        gamelogic_resolveMove(&board, playerStatus, move % gridWidth, move / gridWidth, player);
+        if(gamelogic_updatePlayerStatus(&board, playerStatus, player))
+            winner = player;
+        player = gamelogic_getNextPlayer(playerStatus, player);
+    }
+    gamelogic_freeBoard(&board);
+    gamelogic_freeBoard(&child);
+
+    for(int i=0; i<recordCount; i++)
+    {
+        if(worker->bufferCount >= TUNE_WRITEBUFFER)
+            tuneFlush(worker);
+        uint8_t* record = worker->buffer + worker->bufferCount*TUNE_RECORD_SIZE;
+        for(int j=0; j<EVAL_FEATURE_COUNT; j++)
+        {
+            uint16_t value = (uint16_t)worker->gameRecords[i][j];
+            record[2*j] = value & 0xFF;
+            record[2*j+1] = value >> 8;
+        }
+        record[2*EVAL_FEATURE_COUNT] = (worker->gameMovers[i] == winner) ? 1 : 0;
+        record[2*EVAL_FEATURE_COUNT+1] = 0;
+        worker->bufferCount++;
+    }
+    worker->gameCount++;
+    worker->positionCount += recordCount;
+    return true;
+}
+
+/// @brief Play games until every game of the generator is taken (thread pool task)
+/// @param data Self-play thread
+/// @param threadIndex Thread index (unused)
+static void tunePlayTask(void* data, int threadIndex)
+{
+    (void)threadIndex;
+    struct TuneWorker* worker = data;
+    long gameCount = worker->gen->params.gameCount;
+    int firstGame;
+    while(!worker->failed && (firstGame = SDL_AtomicAdd(&worker->gen->nextGame, TUNE_GAMEBATCH)) < gameCount)
+    {
+        int lastGame = SDL_min(firstGame+TUNE_GAMEBATCH, gameCount);
+        for(int i=firstGame; i<lastGame && !worker->failed; i++)
+            worker->failed = !tunePlayGame(worker, i);
+    }
+    tuneFlush(worker);
+}
+
+bool gametune_playGames(const char* path, const struct TuneGameParams* params)
+{
+    struct TuneGenerator gen;
+    gen.params = *params;
+    if(gen.params.gameCount <= 0)
+        gen.params.gameCount = TUNE_DEFAULT_GAMES;
+    // The game counter is a 32-bit atomic
+    gen.params.gameCount = SDL_min(gen.params.gameCount, SDL_MAX_SINT32-TUNE_GAMEBATCH);
+    int threadCount = (gen.params.threadCount > 0) ? gen.params.threadCount : SDL_GetCPUCount();
+    threadCount = SDL_clamp(threadCount, 1, KTHREADPOOL_MAX_THREADS);
+    SDL_AtomicSet(&gen.nextGame, 0);
+    gen.file = SDL_RWFromFile(path, "wb");
+    gen.fileLock = SDL_CreateMutex();
+
+    KThreadPool* threadPool = kthreadpool_create(threadCount);
+    struct TuneWorker* workers = calloc(threadCount, sizeof(struct TuneWorker));
+    KTimer* timer = ktimer_create();
+    bool success = (gen.file && gen.fileLock && threadPool && workers && timer);
+    for(int i=0; i<threadCount && success; i++)
+    {
+        workers[i].gen = &gen;
+        workers[i].buffer = malloc(TUNE_WRITEBUFFER*TUNE_RECORD_SIZE);
+        workers[i].gameRecords = malloc((3*MAX_GRIDWIDTH*MAX_GRIDHEIGHT+2)*sizeof(workers[i].gameRecords[0]));
+        workers[i].gameMovers = malloc((3*MAX_GRIDWIDTH*MAX_GRIDHEIGHT+2)*sizeof(int));
+        success = (workers[i].buffer && workers[i].gameRecords && workers[i].gameMovers);
+    }
+    if(success)
+        success = (SDL_RWwrite(gen.file, TUNE_MAGIC, 1, 4) == 4) && SDL_WriteLE16(gen.file, TUNE_VERSION) && SDL_WriteLE16(gen.file, EVAL_FEATURE_COUNT);
+
+    if(success)
+    {
+        SDL_Log("Self-play: %ld games, %d threads",gen.params.gameCount,threadCount);
+        // One task per thread, the tasks take batches of games from a shared counter until every game is played
+        for(int i=0; i<threadCount; i++)
+            kthreadpool_submit(threadPool, tunePlayTask, &workers[i]);
+        kthreadpool_wait(threadPool);
+
+        long gameCount = 0;
+        long positionCount = 0;
+        for(int i=0; i<threadCount; i++)
+        {
+            success = success && !workers[i].failed;
+            gameCount += workers[i].gameCount;
+            positionCount += workers[i].positionCount;
+        }
+        float seconds = SDL_max(ktimer_getTimeFloat(timer), 0.001f);
+        SDL_Log("Self-play: %ld games, %ld positions in %.1f s (%.0f games/s, %.0f positions/s)",gameCount,positionCount,seconds,
+            gameCount/seconds,positionCount/seconds);
+    }
+    if(gen.file && SDL_RWclose(gen.file) != 0)
+        success = false;
+
+    if(success)
+        SDL_Log("Self-play: positions written to %s",path);
+    else
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametune_playGames: Couldn't write the self-play positions %s!",path);
+    for(int i=0; workers && i<threadCount; i++)
+    {
+        free(workers[i].buffer);
+        free(workers[i].gameRecords);
+        free(workers[i].gameMovers);
+    }
+    free(workers);
+    ktimer_destroy(timer);
+    kthreadpool_destroy(threadPool);
+    if(gen.fileLock)
+        SDL_DestroyMutex(gen.fileLock);
+    return success;
+}
+
+// Batch of positions read from the positions file
+struct TuneBatch {
+    SDL_RWops* file;
+    uint8_t* records;
+    int capacity;       //Max amount of records
+    int count;          //Amount of records read
+};
+
+// Gradient of the loss over a slice of a batch, computed by a thread pool task
+struct TuneGradientTask {
+    const uint8_t* records;
+    int count;
+    const double* weights;
+    double gradient[EVAL_FEATURE_COUNT];    //Sum of the loss gradients of the records
+    double loss;                            //Sum of the losses of the records
+};
+
+/// @brief Read the next batch of the positions file (thread function, so reading overlaps with the gradient computation)
+/// @param data Batch to read into
+/// @return Always 0
+static int tuneReadBatch(void* data)
+{
+    struct TuneBatch* batch = data;
+    batch->count = (int)SDL_RWread(batch->file, batch->records, TUNE_RECORD_SIZE, batch->capacity);
+    return 0;
+}
+
+/// @brief Compute the log loss and its gradient over a slice of a batch (thread pool task)
+/// @param data Gradient task
+/// @param threadIndex Thread index (unused)
+static void tuneGradientTask(void* data, int threadIndex)
+{
+    (void)threadIndex;
+    struct TuneGradientTask* task = data;
+    memset(task->gradient, 0, sizeof(task->gradient));
+    task->loss = 0;
+    for(int i=0; i<task->count; i++)
+    {
+        const uint8_t* record = task->records + i*TUNE_RECORD_SIZE;
+        double features[EVAL_FEATURE_COUNT];
+        double score = 0;
+        for(int j=0; j<EVAL_FEATURE_COUNT; j++)
+        {
+            features[j] = (int16_t)(record[2*j] | (record[2*j+1] << 8));
+            score += task->weights[j]*features[j];
+        }
+        // The evaluation predicts the chance of the player to move winning
+        double prediction = 1.0/(1.0+exp(-score/TUNE_SIGMOID_SCALE));
+        prediction = SDL_clamp(prediction, 1e-9, 1.0-1e-9);
+        double result = record[2*EVAL_FEATURE_COUNT];
+        task->loss -= result*log(prediction) + (1.0-result)*log(1.0-prediction);
+        double error = (prediction-result)/TUNE_SIGMOID_SCALE;
+        for(int j=0; j<EVAL_FEATURE_COUNT; j++)
+            task->gradient[j] += error*features[j];
+    }
+}
+
+bool gametune_fit(const char* positionsPath, const char* weightsPath, const struct TuneFitParams* params)
+{
+    int epochs = (params->epochs > 0) ? params->epochs : TUNE_DEFAULT_EPOCHS;
+    int batchSize = (params->batchSize > 0) ? params->batchSize : TUNE_DEFAULT_BATCH;
+    double learningRate = (params->learningRate > 0) ? params->learningRate : TUNE_DEFAULT_RATE;
+    int threadCount = (params->threadCount > 0) ? params->threadCount : SDL_GetCPUCount();
+    threadCount = SDL_clamp(threadCount, 1, KTHREADPOOL_MAX_THREADS);
+
+    SDL_RWops* file = SDL_RWFromFile(positionsPath, "rb");
+    if(!file)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametune_fit: Couldn't open the self-play positions %s!",positionsPath);
+        return false;
+    }
+    char magic[4];
+    if(SDL_RWread(file, magic, 1, 4) != 4 || memcmp(magic, TUNE_MAGIC, 4) != 0 || SDL_ReadLE16(file) != TUNE_VERSION || SDL_ReadLE16(file) != EVAL_FEATURE_COUNT)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametune_fit: %s isn't a self-play positions file of this version!",positionsPath);
+        SDL_RWclose(file);
+        return false;
+    }
+
+    // Two batches, one is read while the other one is processed
+    struct TuneBatch batches[2];
+    for(int i=0; i<2; i++)
+        batches[i] = (struct TuneBatch){file, malloc((size_t)batchSize*TUNE_RECORD_SIZE), batchSize, 0};
+    KThreadPool* threadPool = kthreadpool_create(threadCount);
+    struct TuneGradientTask* tasks = calloc(threadCount, sizeof(struct TuneGradientTask));
+    KTimer* timer = ktimer_create();
+    bool success = (batches[0].records && batches[1].records && threadPool && tasks && timer);
+
+    const struct EvalWeights* startWeights = params->weights ? params->weights : &gameeval_defaultWeights;
+    double weights[EVAL_FEATURE_COUNT];
+    double moment[EVAL_FEATURE_COUNT] = {0};
+    double variance[EVAL_FEATURE_COUNT] = {0};
+    for(int i=0; i<EVAL_FEATURE_COUNT; i++)
+        weights[i] = startWeights->weights[i];
+    long steps = 0;
+    long positionCount = 0;
+    if(success)
+        SDL_Log("Weight fitting: %d epochs, %d positions per batch, %d threads",epochs,batchSize,threadCount);
+    for(int epoch=0; epoch<epochs && success; epoch++)
+    {
+        double totalLoss = 0;
+        positionCount = 0;
+        int current = 0;
+        SDL_RWseek(file, TUNE_HEADER_SIZE, RW_SEEK_SET);
+        tuneReadBatch(&batches[current]);
+        while(batches[current].count > 0)
+        {
+            struct TuneBatch* batch = &batches[current];
+            SDL_Thread* reader = SDL_CreateThread(tuneReadBatch, "TuneReader", &batches[1-current]);
+            int sliceSize = (batch->count+threadCount-1)/threadCount;
+            for(int i=0; i<threadCount; i++)
+            {
+                int first = SDL_min(i*sliceSize, batch->count);
+                tasks[i] = (struct TuneGradientTask){batch->records + (size_t)first*TUNE_RECORD_SIZE, SDL_min(sliceSize, batch->count-first), weights};
+                if(!kthreadpool_submit(threadPool, tuneGradientTask, &tasks[i]))
+                    tuneGradientTask(&tasks[i], 0);
+            }
+            kthreadpool_wait(threadPool);
+            if(reader)
+                SDL_WaitThread(reader, NULL);
+            else
+                tuneReadBatch(&batches[1-current]);
+
+            // Adam step with the mean gradient of the batch
+            steps++;
+            for(int i=0; i<EVAL_FEATURE_COUNT; i++)
+            {
+                double gradient = 0;
+                for(int j=0; j<threadCount; j++)
+                    gradient += tasks[j].gradient[i];
+                gradient /= batch->count;
+                moment[i] = TUNE_ADAM_BETA1*moment[i] + (1.0-TUNE_ADAM_BETA1)*gradient;
+                variance[i] = TUNE_ADAM_BETA2*variance[i] + (1.0-TUNE_ADAM_BETA2)*gradient*gradient;
+                double momentEstimate = moment[i]/(1.0-pow(TUNE_ADAM_BETA1, steps));
+                double varianceEstimate = variance[i]/(1.0-pow(TUNE_ADAM_BETA2, steps));
+                weights[i] -= learningRate*momentEstimate/(sqrt(varianceEstimate)+1e-12);
+            }
+            for(int j=0; j<threadCount; j++)
+                totalLoss += tasks[j].loss;
+            positionCount += batch->count;
+            current = 1-current;
+        }
+        if(positionCount == 0)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametune_fit: %s has no positions!",positionsPath);
+            success = false;
+            break;
+        }
+        SDL_Log("Epoch %d: loss %.5f, %ld positions, %.0f positions/s",epoch+1,totalLoss/positionCount,positionCount,
+            (double)positionCount*(epoch+1)/SDL_max(ktimer_getTimeFloat(timer), 0.001f));
+    }
+
+    if(success)
+    {
+        // The search only compares scores, so the weights are scaled to the size of the starting weights before rounding them to keep their precision
+        double startSum = 0;
+        double fittedSum = 0;
+        for(int i=0; i<EVAL_FEATURE_COUNT; i++)
+        {
+            startSum += SDL_abs(startWeights->weights[i]);
+            fittedSum += fabs(weights[i]);
+        }
+        double scale = (startSum > 0 && fittedSum > 0) ? startSum/fittedSum : 1.0;
+        struct EvalWeights fittedWeights;
+        for(int i=0; i<EVAL_FEATURE_COUNT; i++)
+        {
+            fittedWeights.weights[i] = (int)lround(weights[i]*scale);
+            SDL_Log("%-18s %5d (was %d)",tuneFeatureNames[i],fittedWeights.weights[i],startWeights->weights[i]);
+        }
+        success = gameeval_saveWeights(&fittedWeights, weightsPath);
+        if(success)
+            SDL_Log("Weight fitting: weights written to %s",weightsPath);
+        else
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"gametune_fit: Couldn't write the weights %s!",weightsPath);
+    }
+    free(batches[0].records);
+    free(batches[1].records);
+    free(tasks);
+    ktimer_destroy(timer);
+    kthreadpool_destroy(threadPool);
+    SDL_RWclose(file);
+    return success;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gameeval.h"
+
+// Self-play positions file magic number
+#define TUNE_MAGIC "KATP"
+
+// Self-play positions file format version, has to be raised when the file layout changes
+#define TUNE_VERSION 1
+
+// Default amount of self-play games
+#define TUNE_DEFAULT_GAMES 100000
+
+// Default amount of passes over the positions file
+#define TUNE_DEFAULT_EPOCHS 10
+
+// Default amount of positions per gradient step
+#define TUNE_DEFAULT_BATCH 65536
+
+// Default Adam step size in weight units
+#define TUNE_DEFAULT_RATE 0.5f
+
+// Self-play settings
+struct TuneGameParams {
+    long gameCount;                     //Amount of games (TUNE_DEFAULT_GAMES if <= 0)
+    int threadCount;                    //Amount of threads (0 = one per CPU core)
+    uint64_t seed;                      //Seed of the games, the same seed gives the same games
+    const struct EvalWeights* weights;  //Weights the players pick their moves with (NULL = gameeval_defaultWeights)
+};
+
+// Weight fitting settings
+struct TuneFitParams {
+    int epochs;                         //Amount of passes over the positions (TUNE_DEFAULT_EPOCHS if <= 0)
+    int batchSize;                      //Amount of positions per gradient step (TUNE_DEFAULT_BATCH if <= 0)
+    float learningRate;                 //Adam step size in weight units (TUNE_DEFAULT_RATE if <= 0)
+    int threadCount;                    //Amount of threads (0 = one per CPU core)
+    const struct EvalWeights* weights;  //Starting weights (NULL = gameeval_defaultWeights)
+};
+
+/// @brief Play 2 player games on every grid size selectable in the menu and both explosion modes and stream their positions to a file.
+/// The players pick the move with the best evaluation after it (with some random moves to vary the games).
+/// The file starts with TUNE_MAGIC, the version and the feature count (LE16 each), followed by a record for every position:
+/// the features of the player to move minus the features of the opponent (LE16 each), 1 if the player to move won the game or 0 if not (8 bits) and a padding byte.
+/// @param path Output file path
+/// @param params Self-play settings
+/// @return true on success, false if the games couldn't be played or written
+bool gametune_playGames(const char* path, const struct TuneGameParams* params);
+
+/// @brief Fit evaluation weights to the game results of a positions file with logistic regression (the evaluation predicts the chance of winning).
+/// The file is streamed from disk in batches, the next batch is read while the current one is processed by every thread.
+/// @param positionsPath Positions file written by gametune_playGames
+/// @param weightsPath Output weights file path (see gameeval_saveWeights)
+/// @param params Fitting settings
+/// @return true on success, false if the positions couldn't be read or the weights couldn't be written
+bool gametune_fit(const char* positionsPath, const char* weightsPath, const struct TuneFitParams* params);
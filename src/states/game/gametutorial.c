@@ -111,9 +111,7 @@ static void clearGrid(void)
     {
         for(int y=0; y<logicData->gridHeight; y++)
         {
-            logicData->tiles[x][y].playerNum = NOPLAYER;
-            logicData->tiles[x][y].atomCount = 0;
-            logicData->tiles[x][y].explodeTime = 0;
+            gamelogic_setAtoms(x,y,NOPLAYER,0);
         }
     }
 }
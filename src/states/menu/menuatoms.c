@@ -4,13 +4,7 @@
 
 struct MenuAtom menuAtoms[MAX_MENU_ATOMS];
 int menuAtomCount;
-
-// Returns a random float roughly between min and max
-static float randomFloat(float min, float max)
-{
-    max -= min;
-    return ((float)rand() / (float)(RAND_MAX/max)) + min;
-}
+KRandom menuRandom;
 
 // Removes an atom that went out of bounds
 static void removeAtom(int index)
@@ -29,10 +23,10 @@ void menuatoms_spawnAtom(SDL_Color color)
 
     struct MenuAtom* newAtom = &menuAtoms[menuAtomCount++];
     newAtom->y = -48;
-    newAtom->x = rand() % 420 + 30;
-    newAtom->xspeed = randomFloat(-150,150);
-    newAtom->yspeed = randomFloat(75,150);
-    newAtom->atomType = rand() % 3;
+    newAtom->x = krandom_range(&menuRandom,420) + 30;
+    newAtom->xspeed = krandom_float(&menuRandom,-150,150);
+    newAtom->yspeed = krandom_float(&menuRandom,75,150);
+    newAtom->atomType = krandom_range(&menuRandom,3);
     newAtom->atomColor = color;
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <SDL2/SDL.h>
+#include "../../utils/random.h"
 
 // Max amount of background main menu atom textures on the screen
 #define MAX_MENU_ATOMS 20
@@ -16,6 +17,7 @@ struct MenuAtom {
 
 extern struct MenuAtom menuAtoms[MAX_MENU_ATOMS]; // Array containing menu background atom data
 extern int menuAtomCount; // Current amount of atoms in the menu background
+extern KRandom menuRandom; // Random number generator used by the menu background atoms
 
 /// @brief Add a menu atom texture if menuAtomCount < MAX_MENU_ATOMS
 /// @param color The color of the new atom
@@ -5,6 +5,8 @@
 #include "../../game/state.h"
 #include "../../utils/rendertext.h"
 #include "../../game/assetman.h"
+#include "../../utils/wavplayer.h"
+#include "../game/gamelogic.h"
 #include <SDL2/SDL_render.h>
 
 static SDL_Texture* bgImage;
@@ -34,11 +36,12 @@ void menustate_init(SDL_Renderer* rend)
         return;
     }
     menuAtomCount = 0;
+    krandom_seed(&menuRandom, game_newSeed());
 }
 
 void menustate_update(float dt)
 {
-    menuatoms_spawnAtom(atomPlayerColors[rand() & 3]);
+    menuatoms_spawnAtom(atomPlayerColors[krandom_range(&menuRandom,4)]);
     menuatoms_moveAtoms(dt);
     menuui_update();
 }
@@ -58,6 +61,8 @@ void menustate_draw(SDL_Renderer* rend)
     textureRect = (SDL_Rect){133,12,213,70};
     SDL_RenderCopy(rend, logoImage, NULL, &textureRect);
     menuui_draw(rend);
+    rendertext_setTextAlignment(TEXT_ALIGN_CENTER,SCREEN_WIDTH);
+    rendertext_drawTextColored((gameSettings.explosionMode == EXPLOSION_WAVE) ? "Explosions: Wave (Select/Tab to change)" : "Explosions: Sequential (Select/Tab to change)",0,238,(SDL_Color){200,200,200,SDL_ALPHA_OPAQUE});
     rendertext_setTextAlignment(TEXT_ALIGN_RIGHT,SCREEN_WIDTH-4);
     rendertext_drawText("Made by Nightwolf-47",0,SCREEN_HEIGHT-16);
     rendertext_setTextAlignment(TEXT_ALIGN_LEFT,0);
@@ -66,6 +71,12 @@ void menustate_draw(SDL_Renderer* rend)
 
 void menustate_control_pressed(SDL_GameControllerButton button, const SDL_Event *event)
 {
+    if(button == SDL_CONTROLLER_BUTTON_BACK)
+    {
+        gameSettings.explosionMode = (gameSettings.explosionMode == EXPLOSION_WAVE) ? EXPLOSION_SEQUENTIAL : EXPLOSION_WAVE;
+        wavplayer_play(sfxClick);
+        return;
+    }
     menuui_press(button);
 }
 
@@ -30,12 +30,14 @@ static const SDL_Rect normalButtonRect = {0,0,90,45};
 static const SDL_Rect smallButtonRect = {0,0,50,45};
 
 // Player type names in readable format
-static const char* playerTypeStrings[5] = {
+static const char* playerTypeStrings[7] = {
     "None",
     "Human",
     "AI 1",
     "AI 2",
     "AI 3",
+    "AI 4",
+    "AI 5",
 };
 
 // Atom colors for each player, yet again
@@ -109,7 +111,7 @@ static int* getPlayerType(int playerNum)
             playerType = NULL; //Invalid
             break;
     }
-    if(!playerType || *playerType < 0 || *playerType > 4)
+    if(!playerType || *playerType < 0 || *playerType > 6)
         return NULL;
     return playerType;
 }
@@ -158,7 +160,7 @@ static void playerClickCallback(MenuUIButton* menuButton, SDL_GameControllerButt
     {
         int move = 1-(2*(controllerButton == SDL_CONTROLLER_BUTTON_B || controllerButton == SDL_CONTROLLER_BUTTON_Y));
         int min = !moreThan2Players();
-        int max = 4;
+        int max = 6;
         *playerType += move;
         if(*playerType < min)
             *playerType = max;
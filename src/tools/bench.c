@@ -0,0 +1,587 @@
+#include "../game/assetman.h"
+#include "../game/game.h"
+#include "../game/save.h"
+#include "../states/game/gamelogic.h"
+#include "../states/game/gameai.h"
+#include "../states/game/gamebench.h"
+#include "../states/game/gamestate.h"
+#include "../utils/pakread.h"
+#include "../utils/random.h"
+#include "../utils/rendertext.h"
+#include <SDL2/SDL.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Default amount of timed repetitions of every benchmark
+#define BENCH_DEFAULT_REPETITIONS 15
+
+// Default minimum time of a single repetition in milliseconds, the iteration count is raised until a repetition takes at least this long
+#define BENCH_DEFAULT_MINTIME 10
+
+// Time every benchmark runs untimed before the repetitions in milliseconds
+#define BENCH_WARMUPTIME 100
+
+// Max amount of repetitions and benchmark results
+#define BENCH_MAX_REPETITIONS 1000
+#define BENCH_MAX_RESULTS 64
+
+// Default asset PAK path (the game's PAK file, run from the game directory)
+#define BENCH_DEFAULT_PAK "resources.pak"
+
+// Benchmarked function, does the measured operation the given amount of times
+typedef void (*BenchFunction)(void* data, long iterations);
+
+// Untimed preparation of a single benchmarked operation (for operations that would otherwise only hit a cache)
+typedef void (*BenchSetup)(void* data);
+
+// Timing statistics of a benchmark in nanoseconds per operation
+struct BenchResult {
+    char name[48];
+    long iterations;    //Operations per repetition
+    int repetitions;    //Amount of timed repetitions
+    double min;
+    double median;
+    double mean;
+    double stddev;      //Sample standard deviation of the repetitions
+    double max;
+};
+
+// Benchmark settings
+struct BenchSettings {
+    int repetitions;
+    int minTime;            //Minimum time of a repetition in milliseconds
+    const char* filter;     //Only benchmarks with this string in their name are run (NULL = every benchmark)
+};
+
+static struct BenchSettings benchSettings = {BENCH_DEFAULT_REPETITIONS, BENCH_DEFAULT_MINTIME, NULL};
+static struct BenchResult benchResults[BENCH_MAX_RESULTS];
+static int benchResultCount;
+
+// Player statuses of the single atom and chain reaction benchmarks, two players who both have atoms on the board
+static const enum PlayerStatus benchPlayerStatus[4] = {PST_PLAYING, PST_PLAYING, PST_NOTPRESENT, PST_NOTPRESENT};
+
+// Result of every benchmarked operation is added here, so the compiler can't remove the operations
+static volatile long benchSink;
+
+// Board of the single atom benchmark (gamelogic_resolveMove on a compact board, the rules the AI plays with, not the animated game move)
+struct SingleAtomBench {
+    struct KABoard board;
+    struct KABoard emptyBoard;
+    int nextTile;       //Tile the next atom is put on, the board is cleared after every tile got an atom
+};
+
+// Chain reaction benchmark, the move is made on a copy of the position every time
+struct CascadeBench {
+    struct KABoard position;
+    struct KABoard board;
+    Vec2 move;
+};
+
+// Rule-based AI benchmark
+struct AIBench {
+    struct AIContext* context;
+    struct BenchPosition position;
+    int difficulty;
+    KRandom random;
+};
+
+// PAK entry benchmark
+struct PakBench {
+    PakFile* pak;
+    const char* entryPath;
+};
+
+/// @brief Log the command line options
+/// @param program Program name
+static void printUsage(const char* program)
+{
+    SDL_Log("Usage: %s [options]",program);
+    SDL_Log("  --repetitions <number>   timed repetitions of every benchmark (default %d)",BENCH_DEFAULT_REPETITIONS);
+    SDL_Log("  --min-time <ms>          minimum time of a repetition (default %d)",BENCH_DEFAULT_MINTIME);
+    SDL_Log("  --filter <text>          only run the benchmarks with this text in their name");
+    SDL_Log("  --pak <path>             asset PAK used by the PAK and text benchmarks (default %s)",BENCH_DEFAULT_PAK);
+    SDL_Log("  --json <path>            write the results as JSON to this path (- = standard output)");
+    SDL_Log("  --ai-threads <max>       log the AI search speedup from 1 to max threads (0 = one per CPU core) instead of running the microbenchmarks");
+}
+
+/// @brief Get the time of a benchmark function run in nanoseconds
+/// @param function Benchmarked function
+/// @param setup Preparation of every operation (NULL = none), with a setup every operation is timed on its own and the setup time isn't counted
+/// @param data Benchmark data
+/// @param iterations Amount of operations
+/// @return Run time in nanoseconds
+static double benchTime(BenchFunction function, BenchSetup setup, void* data, long iterations)
+{
+    if(!setup)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        function(data, iterations);
+        Uint64 end = SDL_GetPerformanceCounter();
+        return (double)(end-start)*1e9/SDL_GetPerformanceFrequency();
+    }
+    Uint64 ticks = 0;
+    for(long i=0; i<iterations; i++)
+    {
+        setup(data);
+        Uint64 start = SDL_GetPerformanceCounter();
+        function(data, 1);
+        ticks += SDL_GetPerformanceCounter()-start;
+    }
+    return (double)ticks*1e9/SDL_GetPerformanceFrequency();
+}
+
+/// @brief Compare two doubles for qsort
+/// @param a First double
+/// @param b Second double
+/// @return Negative if a < b, positive if a > b, 0 otherwise
+static int compareDoubles(const void* a, const void* b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+/// @brief Check if a benchmark is selected by the name filter
+/// @param name Benchmark name
+/// @return true if the benchmark has to run
+static bool benchSelected(const char* name)
+{
+    return !benchSettings.filter || strstr(name, benchSettings.filter);
+}
+
+/// @brief Measure a benchmark and log and store its result.
+/// The iteration count is doubled until a run takes the minimum repetition time, then the benchmark runs untimed for the warmup time,
+/// then every repetition is timed separately.
+/// @param name Benchmark name
+/// @param function Benchmarked function
+/// @param setup Untimed preparation of every operation (NULL = none)
+/// @param data Benchmark data
+static void benchRun(const char* name, BenchFunction function, BenchSetup setup, void* data)
+{
+    if(!benchSelected(name) || benchResultCount >= BENCH_MAX_RESULTS)
+        return;
+
+    const double minTime = benchSettings.minTime*1e6;
+    long iterations = 1;
+    double time = benchTime(function, setup, data, iterations);
+    while(time < minTime && iterations < LONG_MAX/2)
+    {
+        iterations *= 2;
+        time = benchTime(function, setup, data, iterations);
+    }
+    for(double warmup=time; warmup < BENCH_WARMUPTIME*1e6; )
+        warmup += benchTime(function, setup, data, iterations);
+
+    double times[BENCH_MAX_REPETITIONS];
+    int repetitions = benchSettings.repetitions;
+    double sum = 0;
+    for(int r=0; r<repetitions; r++)
+    {
+        times[r] = benchTime(function, setup, data, iterations)/iterations;
+        sum += times[r];
+    }
+    struct BenchResult* result = &benchResults[benchResultCount++];
+    SDL_strlcpy(result->name, name, sizeof(result->name));
+    result->iterations = iterations;
+    result->repetitions = repetitions;
+    result->mean = sum/repetitions;
+    double squares = 0;
+    for(int r=0; r<repetitions; r++)
+        squares += (times[r]-result->mean)*(times[r]-result->mean);
+    result->stddev = (repetitions > 1) ? sqrt(squares/(repetitions-1)) : 0;
+    qsort(times, repetitions, sizeof(double), compareDoubles);
+    result->min = times[0];
+    result->max = times[repetitions-1];
+    result->median = (repetitions % 2) ? times[repetitions/2] : (times[repetitions/2-1]+times[repetitions/2])/2;
+
+    SDL_Log("%-26s %12.1f ns/op  (min %.1f, max %.1f, mean %.1f +- %.1f%%, %d x %ld ops)",name,result->median,result->min,result->max,
+        result->mean,100.0*result->stddev/SDL_max(result->mean,1e-9),repetitions,iterations);
+}
+
+/// @brief Resolve moves of the first player on empty board tiles in turn, none of them explodes
+/// @param data Single atom benchmark
+/// @param iterations Amount of operations
+static void benchResolveSingle(void* data, long iterations)
+{
+    struct SingleAtomBench* bench = data;
+    struct KABoard* board = &bench->board;
+    long explosions = 0;
+    for(long i=0; i<iterations; i++)
+    {
+        explosions += gamelogic_resolveMove(board, benchPlayerStatus, bench->nextTile % board->gridWidth, bench->nextTile / board->gridWidth, 0);
+        if(++bench->nextTile == board->gridWidth*board->gridHeight)
+        {
+            gamelogic_copyBoard(board, &bench->emptyBoard);
+            bench->nextTile = 0;
+        }
+    }
+    benchSink += explosions;
+}
+
+/// @brief Copy the chain reaction position, the copy time is a part of every chain reaction benchmark
+/// @param data Chain reaction benchmark
+/// @param iterations Amount of operations
+static void benchCopyBoard(void* data, long iterations)
+{
+    struct CascadeBench* bench = data;
+    for(long i=0; i<iterations; i++)
+        gamelogic_copyBoard(&bench->board, &bench->position);
+    benchSink += bench->board.hash;
+}
+
+/// @brief Copy the chain reaction position and make the move that blows it up
+/// @param data Chain reaction benchmark
+/// @param iterations Amount of operations
+static void benchCascade(void* data, long iterations)
+{
+    struct CascadeBench* bench = data;
+    long explosions = 0;
+    for(long i=0; i<iterations; i++)
+    {
+        gamelogic_copyBoard(&bench->board, &bench->position);
+        explosions += gamelogic_resolveMove(&bench->board, benchPlayerStatus, bench->move.x, bench->move.y, 0);
+    }
+    benchSink += explosions;
+}
+
+/// @brief Make the next AI move recompute the tile features of the whole position (benchAIMove setup)
+/// @param data AI benchmark
+static void benchInvalidateAI(void* data)
+{
+    struct AIBench* bench = data;
+    ai_invalidateContext(bench->context);
+}
+
+/// @brief Find a rule-based AI move on the position, the tile features are computed from scratch every time (see benchInvalidateAI)
+/// @param data AI benchmark
+/// @param iterations Amount of operations
+static void benchAIMove(void* data, long iterations)
+{
+    struct AIBench* bench = data;
+    long tiles = 0;
+    for(long i=0; i<iterations; i++)
+    {
+        Vec2 move;
+        if(ai_findMove(bench->context, &bench->position.board, bench->position.playerStatus, bench->position.player, bench->difficulty, &bench->random, &move))
+            tiles += move.x + move.y;
+    }
+    benchSink += tiles;
+}
+
+/// @brief Save the game and load it back
+/// @param data Unused
+/// @param iterations Amount of operations
+static void benchSaveLoad(void* data, long iterations)
+{
+    (void)data;
+    long loaded = 0;
+    for(long i=0; i<iterations; i++)
+    {
+        if(saveGame() && loadGame() >= 0)
+            loaded++;
+    }
+    benchSink += loaded;
+}
+
+/// @brief Load a PAK entry and free it
+/// @param data PAK entry benchmark
+/// @param iterations Amount of operations
+static void benchPakEntry(void* data, long iterations)
+{
+    struct PakBench* bench = data;
+    long size = 0;
+    for(long i=0; i<iterations; i++)
+    {
+        PakEntryData entry = PAK_LoadEntry(bench->pak, bench->entryPath);
+        size += entry.size;
+        PAK_CloseEntry(&entry);
+    }
+    benchSink += size;
+}
+
+/// @brief Measure the width of a text line
+/// @param data Text line
+/// @param iterations Amount of operations
+static void benchLineWidth(void* data, long iterations)
+{
+    const char* line = data;
+    long width = 0;
+    for(long i=0; i<iterations; i++)
+        width += rendertext_getLineWidth(line);
+    benchSink += width;
+}
+
+/// @brief Build a chain reaction position: most tiles are one atom away from exploding and belong to one of two players.
+/// The atoms are put without explosions, so both explosion modes get the same position from the same seed.
+/// @param bench Chain reaction benchmark to write
+/// @param gridWidth Board width
+/// @param gridHeight Board height
+/// @param explosionMode Chain reaction propagation mode
+/// @param seed Random seed
+/// @return true on success, false on allocation failure
+static bool benchMakeCascade(struct CascadeBench* bench, int gridWidth, int gridHeight, enum ExplosionMode explosionMode, uint64_t seed)
+{
+    if(!gamelogic_allocBoard(&bench->position, gridWidth, gridHeight))
+        return false;
+    if(!gamelogic_allocBoard(&bench->board, gridWidth, gridHeight))
+    {
+        gamelogic_freeBoard(&bench->position);
+        return false;
+    }
+    bench->position.explosionMode = explosionMode;
+    KRandom random;
+    krandom_seed(&random, seed);
+    bench->move = (Vec2){-1, -1};
+    int bestDistance = INT32_MAX;
+    for(int y=0; y<gridHeight; y++)
+    {
+        for(int x=0; x<gridWidth; x++)
+        {
+            int crit = 4 - (x == 0 || x == gridWidth-1) - (y == 0 || y == gridHeight-1);
+            int count = (krandom_range(&random, 8) > 0) ? crit-1 : krandom_range(&random, crit);
+            int player = krandom_range(&random, 2);
+            for(int i=0; i<count; i++)
+                gamelogic_resolveMove(&bench->position, benchPlayerStatus, x, y, player);
+            // The move is made by the first player on its critical tile closest to the board center
+            int distance = SDL_abs(2*x-gridWidth) + SDL_abs(2*y-gridHeight);
+            if(count == crit-1 && player == 0 && distance < bestDistance)
+            {
+                bench->move = (Vec2){x, y};
+                bestDistance = distance;
+            }
+        }
+    }
+    return bench->move.x >= 0;
+}
+
+/// @brief Run the board rules benchmarks (single atoms and chain reactions)
+static void benchRules(void)
+{
+    struct SingleAtomBench singleAtom;
+    if(gamelogic_allocBoard(&singleAtom.board, BENCH_GRIDWIDTH, BENCH_GRIDHEIGHT))
+    {
+        if(gamelogic_allocBoard(&singleAtom.emptyBoard, BENCH_GRIDWIDTH, BENCH_GRIDHEIGHT))
+        {
+            singleAtom.nextTile = 0;
+            benchRun("resolvemove/single", benchResolveSingle, NULL, &singleAtom);
+            gamelogic_freeBoard(&singleAtom.emptyBoard);
+        }
+        gamelogic_freeBoard(&singleAtom.board);
+    }
+
+    // From the smallest game grid to boards a lot bigger than the biggest one
+    static const Vec2 cascadeSizes[] = {{MIN_GRIDWIDTH,MIN_GRIDHEIGHT}, {10,6}, {MAX_GRIDWIDTH,MAX_GRIDHEIGHT}, {32,32}, {64,64}};
+    for(int i=0; i<(int)SDL_arraysize(cascadeSizes); i++)
+    {
+        // Sequential chain reactions on boards bigger than the game grids take millions of explosions, those boards only get wave explosions
+        bool gameGrid = (cascadeSizes[i].x <= MAX_GRIDWIDTH && cascadeSizes[i].y <= MAX_GRIDHEIGHT);
+        for(int mode=(gameGrid ? EXPLOSION_SEQUENTIAL : EXPLOSION_WAVE); mode<=EXPLOSION_WAVE; mode++)
+        {
+            char name[48];
+            SDL_snprintf(name, sizeof(name), "cascade/%s/%dx%d", (mode == EXPLOSION_WAVE) ? "wave" : "seq", cascadeSizes[i].x, cascadeSizes[i].y);
+            if(!benchSelected(name))
+                continue;
+            struct CascadeBench cascade;
+            if(!benchMakeCascade(&cascade, cascadeSizes[i].x, cascadeSizes[i].y, mode, i+1))
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_ERROR,"Couldn't make the %s position!",name);
+                continue;
+            }
+            gamelogic_copyBoard(&cascade.board, &cascade.position);
+            SDL_Log("%s: %d explosions per move",name,gamelogic_resolveMove(&cascade.board, benchPlayerStatus, cascade.move.x, cascade.move.y, 0));
+            benchRun(name, benchCascade, NULL, &cascade);
+            if(mode == EXPLOSION_WAVE)
+            {
+                SDL_snprintf(name, sizeof(name), "boardcopy/%dx%d", cascadeSizes[i].x, cascadeSizes[i].y);
+                benchRun(name, benchCopyBoard, NULL, &cascade);
+            }
+            gamelogic_freeBoard(&cascade.position);
+            gamelogic_freeBoard(&cascade.board);
+        }
+    }
+}
+
+/// @brief Run the rule-based AI benchmarks (difficulty 1-3) on a mid-game position
+static void benchAI(void)
+{
+    struct AIBench ai;
+    ai.context = ai_createContext(0);
+    bool positionMade = gamebench_makePosition(&ai.position, 2, 24, 1);
+    if(ai.context && positionMade)
+    {
+        for(ai.difficulty=1; ai.difficulty<=3; ai.difficulty++)
+        {
+            char name[48];
+            SDL_snprintf(name, sizeof(name), "aispecialtiles/ai%d", ai.difficulty);
+            krandom_seed(&ai.random, 1);
+            benchRun(name, benchAIMove, benchInvalidateAI, &ai);
+        }
+    }
+    if(positionMade)
+        gamelogic_freeBoard(&ai.position.board);
+    ai_freeContext(ai.context);
+}
+
+/// @brief Run the save and load benchmark on a mid-game position, the save file is written next to the real one and removed afterwards
+static void benchSave(void)
+{
+    if(!benchSelected("saveload"))
+        return;
+    struct BenchPosition position;
+    if(!gamebench_makePosition(&position, 2, 24, 2))
+        return;
+    int playerTypes[4] = {1, 1, 0, 0};
+    gamelogic_init(BENCH_GRIDWIDTH, BENCH_GRIDHEIGHT, &playerTypes, EXPLOSION_SEQUENTIAL, 1);
+    gameTimer = ktimer_create();
+    if(logicData && gameTimer)
+    {
+        for(int y=0; y<BENCH_GRIDHEIGHT; y++)
+        {
+            for(int x=0; x<BENCH_GRIDWIDTH; x++)
+            {
+                int index = BOARD_INDEX(&position.board,x,y);
+                gamelogic_setAtoms(x, y, (position.board.owner[index] == NOOWNER) ? NOPLAYER : position.board.owner[index], position.board.count[index]);
+            }
+        }
+        const char* gameSavePath = saveFilePath;
+        saveFilePath = "bench.ksf";
+        benchRun("saveload", benchSaveLoad, NULL, NULL);
+        remove(saveFilePath);
+        saveFilePath = gameSavePath;
+    }
+    gamelogic_stop();
+    ai_Quit();
+    ktimer_destroy(gameTimer);
+    gameTimer = NULL;
+    gamelogic_freeBoard(&position.board);
+}
+
+/// @brief Run the PAK entry and text measurement benchmarks
+/// @param pakPath Asset PAK path
+static void benchAssets(const char* pakPath)
+{
+    if(!benchSelected("pak/") && !benchSelected("rendertext/"))
+        return;
+    PakFile* pak = PAK_OpenFile(pakPath);
+    if(!pak)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,"Couldn't open %s, skipping the PAK and text benchmarks",pakPath);
+        return;
+    }
+    // A missing entry only searches the entry names, the other entries are read from the file as well
+    static const char* entryPaths[][2] = {
+        {"pak/missing", "game/missing.bin"},
+        {"pak/evalweights", "game/evalweights.bin"},
+        {"pak/font", "font/DejaVuSans.ttf"}
+    };
+    for(int i=0; i<(int)SDL_arraysize(entryPaths); i++)
+    {
+        struct PakBench bench = {pak, entryPaths[i][1]};
+        benchRun(entryPaths[i][0], benchPakEntry, NULL, &bench);
+    }
+    PAK_CloseFile(pak);
+
+    if(!benchSelected("rendertext/"))
+        return;
+    // The font atlas needs a renderer, a software renderer drawing to a small surface doesn't need a window
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 16, 16, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    if(renderer && assetman_init(pakPath) && assetman_initFont(renderer, "font/DejaVuSans.ttf", 14))
+    {
+        benchRun("rendertext/shortline", benchLineWidth, NULL, "Player 1 won!");
+        benchRun("rendertext/longline", benchLineWidth, NULL, "Press the directional buttons to move the tile selector and X to put an atom");
+    }
+    else
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,"Couldn't load the font from %s, skipping the text benchmarks",pakPath);
+    }
+    rendertext_stop();
+    assetman_stop();
+    if(renderer)
+        SDL_DestroyRenderer(renderer);
+    if(surface)
+        SDL_FreeSurface(surface);
+}
+
+/// @brief Write the benchmark results as JSON
+/// @param path Output file path (- = standard output)
+/// @return true on success, false if the file couldn't be written
+static bool writeJSON(const char* path)
+{
+    FILE* file = (strcmp(path,"-") == 0) ? stdout : fopen(path, "w");
+    if(!file)
+        return false;
+    fprintf(file, "{\n  \"repetitions\": %d,\n  \"min_time_ms\": %d,\n  \"benchmarks\": [\n",benchSettings.repetitions,benchSettings.minTime);
+    for(int i=0; i<benchResultCount; i++)
+    {
+        const struct BenchResult* result = &benchResults[i];
+        fprintf(file, "    {\"name\": \"%s\", \"iterations\": %ld, \"repetitions\": %d, \"ns_per_op\": {\"median\": %.3f, \"min\": %.3f, \"max\": %.3f, \"mean\": %.3f, \"stddev\": %.3f}}%s\n",
+            result->name,result->iterations,result->repetitions,result->median,result->min,result->max,result->mean,result->stddev,
+            (i+1 < benchResultCount) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    if(file == stdout)
+        return fflush(file) == 0;
+    return fclose(file) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* pakPath = BENCH_DEFAULT_PAK;
+    const char* jsonPath = NULL;
+    int aiMaxThreads = -1;
+    for(int i=1; i<argc; i++)
+    {
+        if(strcmp(argv[i],"--repetitions") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            benchSettings.repetitions = SDL_clamp(value,1,BENCH_MAX_REPETITIONS);
+        }
+        else if(strcmp(argv[i],"--min-time") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            benchSettings.minTime = SDL_max(value,1);
+        }
+        else if(strcmp(argv[i],"--filter") == 0 && i+1 < argc)
+            benchSettings.filter = argv[++i];
+        else if(strcmp(argv[i],"--pak") == 0 && i+1 < argc)
+            pakPath = argv[++i];
+        else if(strcmp(argv[i],"--json") == 0 && i+1 < argc)
+            jsonPath = argv[++i];
+        else if(strcmp(argv[i],"--ai-threads") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiMaxThreads = SDL_max(value,0);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(aiMaxThreads >= 0)
+    {
+        gamebench_runAI(aiMaxThreads);
+        return 0;
+    }
+
+    // The searches and the save benchmark run on this thread only
+    aiThreadCount = 1;
+    aiTableSize = 0;
+
+    benchRules();
+    benchAI();
+    benchSave();
+    benchAssets(pakPath);
+
+    if(jsonPath && !writeJSON(jsonPath))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,"Couldn't write the benchmark results to %s!",jsonPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "../states/game/gamebookgen.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @brief Log the command line options
+/// @param program Program name
+static void printUsage(const char* program)
+{
+    SDL_Log("Usage: %s <output path> [options]",program);
+    SDL_Log("Generates the opening book packed as game/openings.bin");
+    SDL_Log("  --plies <number>       plies from the empty board covered by the book (default %d)",BOOK_DEFAULT_PLIES);
+    SDL_Log("  --search-time <ms>     time budget of every book search (default %d)",BOOK_DEFAULT_SEARCHTIME);
+    SDL_Log("  --threads <number>     search threads (default 0 = one per CPU core)");
+}
+
+int main(int argc, char** argv)
+{
+    int plies = BOOK_DEFAULT_PLIES;
+    int timeLimit = BOOK_DEFAULT_SEARCHTIME;
+    int threadCount = 0;
+    const char* path = NULL;
+    for(int i=1; i<argc; i++)
+    {
+        if(strcmp(argv[i],"--plies") == 0 && i+1 < argc)
+            plies = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--search-time") == 0 && i+1 < argc)
+            timeLimit = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--threads") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            threadCount = SDL_max(value,0);
+        }
+        else if(argv[i][0] != '-' && !path)
+            path = argv[i];
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if(!path)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    return gamebookgen_generate(path, plies, timeLimit, threadCount) ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#include "../states/game/gametune.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @brief Log the command line options
+/// @param program Program name
+static void printUsage(const char* program)
+{
+    SDL_Log("Usage: %s play <positions path> [options]",program);
+    SDL_Log("       %s fit <positions path> <weights path> [options]",program);
+    SDL_Log("  --games <number>      self-play games (default %d)",TUNE_DEFAULT_GAMES);
+    SDL_Log("  --seed <number>       self-play seed (default 1)");
+    SDL_Log("  --epochs <number>     passes over the positions (default %d)",TUNE_DEFAULT_EPOCHS);
+    SDL_Log("  --batch <number>      positions per gradient step (default %d)",TUNE_DEFAULT_BATCH);
+    SDL_Log("  --rate <number>       step size in weight units (default %.2f)",TUNE_DEFAULT_RATE);
+    SDL_Log("  --weights <path>      weights the games are played with or the fitting starts from (default: built-in weights)");
+    SDL_Log("  --threads <number>    threads (default 0 = one per CPU core)");
+}
+
+/// @brief Load a weights file
+/// @param path Weights file path
+/// @param weights Weights to write
+/// @return true on success, false if the file couldn't be read or is invalid
+static bool loadWeightsFile(const char* path, struct EvalWeights* weights)
+{
+    SDL_RWops* file = SDL_RWFromFile(path, "rb");
+    if(!file)
+        return false;
+    Sint64 size = SDL_RWsize(file);
+    void* data = (size > 0) ? malloc(size) : NULL;
+    bool loaded = data && SDL_RWread(file, data, size, 1) == 1 && gameeval_loadWeights(weights, data, size);
+    free(data);
+    SDL_RWclose(file);
+    return loaded;
+}
+
+int main(int argc, char** argv)
+{
+    struct TuneGameParams gameParams = {0, 0, 1, NULL};
+    struct TuneFitParams fitParams = {0, 0, 0, 0, NULL};
+    struct EvalWeights weights;
+    const char* paths[3] = {NULL};
+    int pathCount = 0;
+    for(int i=1; i<argc; i++)
+    {
+        if(strcmp(argv[i],"--games") == 0 && i+1 < argc)
+            gameParams.gameCount = atol(argv[++i]);
+        else if(strcmp(argv[i],"--seed") == 0 && i+1 < argc)
+            gameParams.seed = strtoull(argv[++i],NULL,0);
+        else if(strcmp(argv[i],"--epochs") == 0 && i+1 < argc)
+            fitParams.epochs = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--batch") == 0 && i+1 < argc)
+            fitParams.batchSize = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--rate") == 0 && i+1 < argc)
+            fitParams.learningRate = atof(argv[++i]);
+        else if(strcmp(argv[i],"--threads") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            gameParams.threadCount = fitParams.threadCount = SDL_max(value,0);
+        }
+        else if(strcmp(argv[i],"--weights") == 0 && i+1 < argc)
+        {
+            if(!loadWeightsFile(argv[++i], &weights))
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_ERROR,"Couldn't load the weights %s!",argv[i]);
+                return 1;
+            }
+            gameParams.weights = fitParams.weights = &weights;
+        }
+        else if(argv[i][0] != '-' && pathCount < 3)
+            paths[pathCount++] = argv[i];
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(pathCount == 2 && strcmp(paths[0],"play") == 0)
+        return gametune_playGames(paths[1], &gameParams) ? 0 : 1;
+    if(pathCount == 3 && strcmp(paths[0],"fit") == 0)
+        return gametune_fit(paths[1], paths[2], &fitParams) ? 0 : 1;
+    printUsage(argv[0]);
+    return 1;
+}
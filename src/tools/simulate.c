@@ -0,0 +1,173 @@
+#include "../states/game/gamelogic.h"
+#include "../states/game/gameai.h"
+#include "../utils/timer.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Default amount of simulated games
+#define SIM_DEFAULT_GAMES 100
+
+// Default grid size (the default game grid size)
+#define SIM_DEFAULT_WIDTH 10
+#define SIM_DEFAULT_HEIGHT 6
+
+// Time step of a simulated game tick in seconds, long enough to finish every atom animation in a single tick
+#define SIM_TICK 1000.0f
+
+// Counters of the simulated games
+struct SimStats {
+    long games;         //Finished games
+    long moves;         //Moves made by every player
+    long explosions;    //Tiles blown up by chain reactions
+    long wins[4];       //Games won by every player
+};
+
+static struct SimStats simStats;
+
+/// @brief Log the command line options
+/// @param program Program name
+static void printUsage(const char* program)
+{
+    SDL_Log("Usage: %s [options]",program);
+    SDL_Log("  --games <number>         games to play (default %d)",SIM_DEFAULT_GAMES);
+    SDL_Log("  --players <list>         AI difficulty of every player separated by commas, 1-5 or 0 for no player (default 3,3)");
+    SDL_Log("  --width <tiles>          grid width (default %d)",SIM_DEFAULT_WIDTH);
+    SDL_Log("  --height <tiles>         grid height (default %d)",SIM_DEFAULT_HEIGHT);
+    SDL_Log("  --wave                   play with wave explosions instead of sequential ones");
+    SDL_Log("  --search-time <ms>       time budget of the difficulty 4 and 5 AI (0 = no limit, default %d and %d)",aiSearchParams.timeLimit,aiMCTSParams.timeLimit);
+    SDL_Log("  --search-depth <plies>   max search depth of the difficulty 4 AI (default %d)",aiSearchParams.maxDepth);
+    SDL_Log("  --playouts <number>      max playouts of the difficulty 5 AI (0 = no limit, default %d)",aiMCTSParams.maxPlayouts);
+    SDL_Log("  --threads <number>       AI search threads (default 0 = one per CPU core)");
+    SDL_Log("  --seed <number>          seed of the first game, every next game adds 1 to it (default 1)");
+}
+
+/// @brief Parse a comma separated list of AI difficulties into game player types
+/// @param list Difficulty list
+/// @param playerTypes Player types to write (0 = no player, difficulty+1 otherwise)
+/// @return true if the list is valid and has at least 2 players, false otherwise
+static bool parsePlayers(const char* list, int playerTypes[4])
+{
+    int playerCount = 0;
+    memset(playerTypes, 0, 4*sizeof(int));
+    for(int i=0; i<4 && *list; i++)
+    {
+        char* end;
+        long difficulty = strtol(list, &end, 10);
+        if(end == list || difficulty < 0 || difficulty > 5 || (*end != ',' && *end != '\0'))
+            return false;
+        playerTypes[i] = (difficulty > 0) ? difficulty+1 : 0;
+        playerCount += (difficulty > 0);
+        list = (*end == ',') ? end+1 : end;
+    }
+    return playerCount >= 2 && *list == '\0';
+}
+
+/// @brief Count the moves and explosions of the simulated games
+/// @param event Game event
+/// @param tileCount Amount of tiles the event happened on
+static void simEvent(enum GameEvent event, int tileCount)
+{
+    if(event == GEV_ATOMPUT)
+        simStats.moves++;
+    else
+        simStats.explosions += tileCount;
+}
+
+/// @brief Stop the simulation on a game logic error, like the game does
+/// @param str Error message
+static void simError(const char* str)
+{
+    SDL_LogError(SDL_LOG_CATEGORY_ERROR,"Simulation: %s",str);
+    exit(1);
+}
+
+// Headless presenter, messages are logged and events are only counted
+static const struct GamePresenter simPresenter = {NULL, simError, simEvent};
+
+int main(int argc, char** argv)
+{
+    long gameCount = SIM_DEFAULT_GAMES;
+    int gridWidth = SIM_DEFAULT_WIDTH;
+    int gridHeight = SIM_DEFAULT_HEIGHT;
+    int playerTypes[4] = {4, 4, 0, 0};
+    enum ExplosionMode explosionMode = EXPLOSION_SEQUENTIAL;
+    uint64_t seed = 1;
+    for(int i=1; i<argc; i++)
+    {
+        if(strcmp(argv[i],"--games") == 0 && i+1 < argc)
+            gameCount = atol(argv[++i]);
+        else if(strcmp(argv[i],"--players") == 0 && i+1 < argc && parsePlayers(argv[i+1], playerTypes))
+            i++;
+        else if(strcmp(argv[i],"--width") == 0 && i+1 < argc)
+            gridWidth = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--height") == 0 && i+1 < argc)
+            gridHeight = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--wave") == 0)
+            explosionMode = EXPLOSION_WAVE;
+        else if(strcmp(argv[i],"--search-time") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiSearchParams.timeLimit = aiMCTSParams.timeLimit = SDL_max(value,0);
+        }
+        else if(strcmp(argv[i],"--search-depth") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiSearchParams.maxDepth = SDL_clamp(value,1,SEARCH_MAX_DEPTH);
+        }
+        else if(strcmp(argv[i],"--playouts") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiMCTSParams.maxPlayouts = SDL_max(value,0);
+        }
+        else if(strcmp(argv[i],"--threads") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiThreadCount = SDL_max(value,0);
+        }
+        else if(strcmp(argv[i],"--seed") == 0 && i+1 < argc)
+            seed = strtoull(argv[++i],NULL,0);
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if(gameCount < 1 || gridWidth < 1 || gridWidth > MAX_GRID_WIDTH || gridHeight < 1 || gridHeight > MAX_GRID_HEIGHT)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Every AI move is made right away on this thread, there's nothing to render in the meantime
+    aiMoveDelay = 0;
+    aiWorkerThread = false;
+    aiPondering = false;
+    gamelogic_setPresenter(&simPresenter);
+
+    KTimer* timer = ktimer_create();
+    for(long i=0; i<gameCount; i++)
+    {
+        gamelogic_init(gridWidth, gridHeight, &playerTypes, explosionMode, seed+i);
+        if(!logicData)
+            return 1;
+        while(logicData->playerWon == NOPLAYER)
+            gamelogic_tick(SIM_TICK);
+        simStats.wins[logicData->playerWon]++;
+        simStats.games++;
+    }
+    float seconds = SDL_max(ktimer_getTimeFloat(timer), 0.001f);
+    gamelogic_stop();
+    ai_Quit();
+    ktimer_destroy(timer);
+
+    SDL_Log("%ld games on a %d x %d grid in %.2f s, %.1f moves and %.1f explosions per game",simStats.games,gridWidth,gridHeight,seconds,
+        (double)simStats.moves/simStats.games,(double)simStats.explosions/simStats.games);
+    SDL_Log("%.1f games/s, %.0f moves/s, %.0f explosions/s",simStats.games/seconds,simStats.moves/seconds,simStats.explosions/seconds);
+    for(int p=0; p<4; p++)
+    {
+        if(playerTypes[p] > 0)
+            SDL_Log("Player %d (AI %d): %ld wins (%.1f%%)",p+1,playerTypes[p]-1,simStats.wins[p],100.0*simStats.wins[p]/simStats.games);
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "../states/game/gametablebasegen.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Grid size of the tablebase packed as game/tablebase.bin (the smallest grid selectable in the menu)
+#define TOOL_DEFAULT_WIDTH 5
+#define TOOL_DEFAULT_HEIGHT 4
+
+/// @brief Log the command line options
+/// @param program Program name
+static void printUsage(const char* program)
+{
+    SDL_Log("Usage: %s <output path> [options]",program);
+    SDL_Log("  --width <tiles>        grid width (default %d)",TOOL_DEFAULT_WIDTH);
+    SDL_Log("  --height <tiles>       grid height (default %d)",TOOL_DEFAULT_HEIGHT);
+    SDL_Log("  --wave                 solve wave explosion mode positions instead of sequential ones");
+    SDL_Log("  --roots <number>       amount of random positions to solve (default %d)",TABLEBASE_DEFAULT_ROOTS);
+    SDL_Log("  --atoms <number>       atoms on the board of every random position (default %d)",TABLEBASE_DEFAULT_MINATOMS);
+    SDL_Log("  --nodes <number>       positions the solver may visit for every random position (default %d)",TABLEBASE_DEFAULT_NODELIMIT);
+    SDL_Log("  --min-proof <number>   positions a proof has to visit for the position to be written (default %d)",TABLEBASE_DEFAULT_MINPROOF);
+    SDL_Log("  --threads <number>     solver threads (default 0 = one per CPU core)");
+    SDL_Log("  --seed <number>        random position seed (default 1)");
+}
+
+int main(int argc, char** argv)
+{
+    struct TablebaseParams params = {TOOL_DEFAULT_WIDTH, TOOL_DEFAULT_HEIGHT, EXPLOSION_SEQUENTIAL, 0, 0, 0, 0, 0, 1};
+    const char* path = NULL;
+    for(int i=1; i<argc; i++)
+    {
+        if(strcmp(argv[i],"--width") == 0 && i+1 < argc)
+            params.gridWidth = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--height") == 0 && i+1 < argc)
+            params.gridHeight = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--wave") == 0)
+            params.explosionMode = EXPLOSION_WAVE;
+        else if(strcmp(argv[i],"--roots") == 0 && i+1 < argc)
+            params.rootCount = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--atoms") == 0 && i+1 < argc)
+            params.minAtoms = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--nodes") == 0 && i+1 < argc)
+            params.nodeLimit = atol(argv[++i]);
+        else if(strcmp(argv[i],"--min-proof") == 0 && i+1 < argc)
+            params.minProofNodes = atol(argv[++i]);
+        else if(strcmp(argv[i],"--threads") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            params.threadCount = SDL_max(value,0);
+        }
+        else if(strcmp(argv[i],"--seed") == 0 && i+1 < argc)
+            params.seed = strtoull(argv[++i],NULL,0);
+        else if(argv[i][0] != '-' && !path)
+            path = argv[i];
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if(!path || params.gridWidth < 1 || params.gridWidth > MAX_GRID_WIDTH || params.gridHeight < 1 || params.gridHeight > MAX_GRID_HEIGHT)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    return gametablebasegen_generate(path, &params) ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include "../states/game/gametournament.h"
+#include "../states/game/gameai.h"
+#include "../game/game.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @brief Log the command line options
+/// @param program Program name
+static void printUsage(const char* program)
+{
+    SDL_Log("Usage: %s [options]",program);
+    SDL_Log("  --players <list>         AI difficulty (1-5) of every entrant separated by commas, 2-%d entrants (default 1,2,3)",TOURNAMENT_MAX_ENTRANTS);
+    SDL_Log("  --seats <min>-<max>      players per game, 2-4 (default 2-4, limited to the amount of entrants)");
+    SDL_Log("  --width <tiles>          only play on this grid width (default every width from %d to %d)",MIN_GRIDWIDTH,MAX_GRIDWIDTH);
+    SDL_Log("  --height <tiles>         only play on this grid height (default every height from %d to %d)",MIN_GRIDHEIGHT,MAX_GRIDHEIGHT);
+    SDL_Log("  --wave                   play with wave explosions instead of sequential ones");
+    SDL_Log("  --rounds <number>        times every match is played (default %d)",TOURNAMENT_DEFAULT_ROUNDS);
+    SDL_Log("  --threads <number>       threads playing games (default 0 = one per CPU core)");
+    SDL_Log("  --table-size <MB>        transposition table size of every thread (default %d)",TOURNAMENT_DEFAULT_TABLESIZE);
+    SDL_Log("  --search-time <ms>       time budget of the difficulty 4 and 5 AI (0 = no limit, default %d and %d)",aiSearchParams.timeLimit,aiMCTSParams.timeLimit);
+    SDL_Log("  --search-depth <plies>   max search depth of the difficulty 4 AI (default %d)",aiSearchParams.maxDepth);
+    SDL_Log("  --playouts <number>      max playouts of the difficulty 5 AI (0 = no limit, default %d)",aiMCTSParams.maxPlayouts);
+    SDL_Log("  --seed <number>          seed of the first game, every next game adds 1 to it (default 1)");
+}
+
+/// @brief Parse a comma separated list of AI difficulties into tournament entrants
+/// @param list Difficulty list
+/// @param params Tournament settings to write the entrants to
+/// @return true if the list is valid and has 2-TOURNAMENT_MAX_ENTRANTS entrants, false otherwise
+static bool parseEntrants(const char* list, struct TournamentParams* params)
+{
+    params->entrantCount = 0;
+    while(*list && params->entrantCount < TOURNAMENT_MAX_ENTRANTS)
+    {
+        char* end;
+        long difficulty = strtol(list, &end, 10);
+        if(end == list || difficulty < 1 || difficulty > 5 || (*end != ',' && *end != '\0'))
+            return false;
+        params->entrants[params->entrantCount++] = difficulty;
+        list = (*end == ',') ? end+1 : end;
+    }
+    return params->entrantCount >= 2 && *list == '\0';
+}
+
+int main(int argc, char** argv)
+{
+    struct TournamentParams params = {
+        {1, 2, 3}, 3,
+        2, 4,
+        MIN_GRIDWIDTH, MAX_GRIDWIDTH, MIN_GRIDHEIGHT, MAX_GRIDHEIGHT,
+        EXPLOSION_SEQUENTIAL,
+        TOURNAMENT_DEFAULT_ROUNDS, 0, TOURNAMENT_DEFAULT_TABLESIZE, 1
+    };
+    for(int i=1; i<argc; i++)
+    {
+        if(strcmp(argv[i],"--players") == 0 && i+1 < argc && parseEntrants(argv[i+1], &params))
+            i++;
+        else if(strcmp(argv[i],"--seats") == 0 && i+1 < argc && SDL_sscanf(argv[i+1], "%d-%d", &params.minSeats, &params.maxSeats) == 2)
+            i++;
+        else if(strcmp(argv[i],"--width") == 0 && i+1 < argc)
+            params.minWidth = params.maxWidth = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--height") == 0 && i+1 < argc)
+            params.minHeight = params.maxHeight = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--wave") == 0)
+            params.explosionMode = EXPLOSION_WAVE;
+        else if(strcmp(argv[i],"--rounds") == 0 && i+1 < argc)
+            params.rounds = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--threads") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            params.threadCount = SDL_max(value,0);
+        }
+        else if(strcmp(argv[i],"--table-size") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            params.tableSize = SDL_max(value,0);
+        }
+        else if(strcmp(argv[i],"--search-time") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiSearchParams.timeLimit = aiMCTSParams.timeLimit = SDL_max(value,0);
+        }
+        else if(strcmp(argv[i],"--search-depth") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiSearchParams.maxDepth = SDL_clamp(value,1,SEARCH_MAX_DEPTH);
+        }
+        else if(strcmp(argv[i],"--playouts") == 0 && i+1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            aiMCTSParams.maxPlayouts = SDL_max(value,0);
+        }
+        else if(strcmp(argv[i],"--seed") == 0 && i+1 < argc)
+            params.seed = strtoull(argv[++i],NULL,0);
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    return gametournament_run(&params) ? 0 : 1;
+}
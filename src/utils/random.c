@@ -0,0 +1,51 @@
+#include "random.h"
+
+static uint32_t rotl(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+// splitmix64 step, used to spread the seed bits over the whole generator state
+static uint64_t splitmix64(uint64_t* x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void krandom_seed(KRandom* random, uint64_t seed)
+{
+    for(int i=0; i<4; i+=2)
+    {
+        uint64_t value = splitmix64(&seed);
+        random->s[i] = (uint32_t)value;
+        random->s[i+1] = (uint32_t)(value >> 32);
+    }
+}
+
+uint32_t krandom_next(KRandom* random)
+{
+    uint32_t* s = random->s;
+    uint32_t result = rotl(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 11);
+    return result;
+}
+
+int krandom_range(KRandom* random, int max)
+{
+    // Multiply-shift maps the value to the range without the modulo bias of low bits
+    return (int)(((uint64_t)krandom_next(random) * (uint32_t)max) >> 32);
+}
+
+float krandom_float(KRandom* random, float min, float max)
+{
+    // 24 random bits fit exactly in a float mantissa
+    return min + (krandom_next(random) >> 8) * (1.0f/16777216.0f) * (max-min);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+
+// Random number generator state (xoshiro128**), every subsystem that needs random numbers owns its own state
+typedef struct KRandom {
+    uint32_t s[4];
+} KRandom;
+
+/// @brief Seed a random number generator, the same seed always gives the same sequence
+/// @param random Random number generator state
+/// @param seed Seed value
+void krandom_seed(KRandom* random, uint64_t seed);
+
+/// @brief Get the next random 32-bit value
+/// @param random Random number generator state
+/// @return Random value
+uint32_t krandom_next(KRandom* random);
+
+/// @brief Get a random integer in a range
+/// @param random Random number generator state
+/// @param max Upper bound (exclusive, has to be > 0)
+/// @return Random value between 0 and max-1
+int krandom_range(KRandom* random, int max);
+
+/// @brief Get a random float in a range
+/// @param random Random number generator state
+/// @param min Lower bound (inclusive)
+/// @param max Upper bound (exclusive)
+/// @return Random value between min and max
+float krandom_float(KRandom* random, float min, float max);
@@ -98,10 +98,7 @@ bool rendertext_init(SDL_Renderer* rend, const char* fontFileName, float height)
     return initSuccess;
 }
 
-/// @brief Get a width of a text line
-/// @param str String pointer starting with the line to check
-/// @return Line width in pixels
-static int getLineWidth(const char* str)
+int rendertext_getLineWidth(const char* str)
 {
     int curx = 0;
     int width = 0;
@@ -127,9 +124,9 @@ static int getAlignmentX(const char* str, int x, int textWidth)
     switch(textAlign)
     {
         case TEXT_ALIGN_RIGHT:
-            return x + (textWidth - getLineWidth(str));
+            return x + (textWidth - rendertext_getLineWidth(str));
         case TEXT_ALIGN_CENTER:
-            return x + ((textWidth - getLineWidth(str)) / 2);
+            return x + ((textWidth - rendertext_getLineWidth(str)) / 2);
         case TEXT_ALIGN_LEFT:
         default:
             return x;
@@ -42,6 +42,11 @@ void rendertext_drawTextColored(const char* str, int x, int y, SDL_Color color);
 /// @param y Text Y position
 void rendertext_drawText(const char* str, int x, int y);
 
+/// @brief Get the width of a text line
+/// @param str String pointer starting with the line to check (the line ends at the first newline)
+/// @return Line width in pixels
+int rendertext_getLineWidth(const char* str);
+
 /// @brief Returns the current text alignment enum and puts the current text width in the textWidth pointer if it's not NULL.
 /// @param textWidth Optional pointer to put the text width to
 /// @return Current TextAlignment enum 
@@ -0,0 +1,220 @@
+#include "threadpool.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+
+struct KTask {
+    KTaskFunction function;
+    void* data;
+};
+
+// Task deque of a single thread, the owner takes the newest tasks from the bottom and other threads steal the oldest ones from the top
+struct KTaskDeque {
+    SDL_SpinLock lock;
+    int top;        //Index of the oldest task
+    int bottom;     //Index after the newest task
+    struct KTask tasks[KTHREADPOOL_DEQUE_SIZE];
+};
+
+struct KThreadPoolWorker {
+    KThreadPool* pool;
+    int index;
+};
+
+struct KThreadPool {
+    int threadCount;
+    SDL_Thread* threads[KTHREADPOOL_MAX_THREADS];
+    struct KThreadPoolWorker workers[KTHREADPOOL_MAX_THREADS];
+    struct KTaskDeque* deques;  //Task deque of every thread
+    SDL_mutex* mutex;
+    SDL_cond* workCond;         //Signaled when a task is queued or the pool is stopped
+    SDL_cond* doneCond;         //Signaled when the last pending task is done
+    SDL_atomic_t queued;        //Amount of tasks waiting in the deques
+    SDL_atomic_t pending;       //Amount of submitted tasks that aren't done yet
+    SDL_atomic_t nextDeque;     //Counter used to spread submitted tasks over the deques
+    bool quit;                  //Should the pool threads stop (protected by mutex)
+};
+
+static bool pushTask(struct KTaskDeque* deque, struct KTask task)
+{
+    bool pushed = false;
+    SDL_AtomicLock(&deque->lock);
+    if(deque->bottom - deque->top < KTHREADPOOL_DEQUE_SIZE)
+    {
+        deque->tasks[deque->bottom % KTHREADPOOL_DEQUE_SIZE] = task;
+        deque->bottom++;
+        pushed = true;
+    }
+    SDL_AtomicUnlock(&deque->lock);
+    return pushed;
+}
+
+static bool popTask(struct KTaskDeque* deque, struct KTask* task)
+{
+    bool popped = false;
+    SDL_AtomicLock(&deque->lock);
+    if(deque->bottom > deque->top)
+    {
+        deque->bottom--;
+        *task = deque->tasks[deque->bottom % KTHREADPOOL_DEQUE_SIZE];
+        popped = true;
+    }
+    SDL_AtomicUnlock(&deque->lock);
+    return popped;
+}
+
+static bool stealTask(struct KTaskDeque* deque, struct KTask* task)
+{
+    bool stolen = false;
+    SDL_AtomicLock(&deque->lock);
+    if(deque->bottom > deque->top)
+    {
+        *task = deque->tasks[deque->top % KTHREADPOOL_DEQUE_SIZE];
+        deque->top++;
+        stolen = true;
+    }
+    SDL_AtomicUnlock(&deque->lock);
+    return stolen;
+}
+
+/// @brief Take a task from the thread deque or steal one from the other threads
+/// @param pool Thread pool
+/// @param index Thread index
+/// @param task Task to write to
+/// @return true if a task was found
+static bool getTask(KThreadPool* pool, int index, struct KTask* task)
+{
+    bool found = popTask(&pool->deques[index], task);
+    for(int i=1; i<pool->threadCount && !found; i++)
+        found = stealTask(&pool->deques[(index+i) % pool->threadCount], task);
+    if(found)
+        SDL_AtomicAdd(&pool->queued, -1);
+    return found;
+}
+
+static void runTask(KThreadPool* pool, struct KTask task, int index)
+{
+    task.function(task.data, index);
+    if(SDL_AtomicAdd(&pool->pending, -1) == 1)
+    {
+        SDL_LockMutex(pool->mutex);
+        SDL_CondBroadcast(pool->doneCond);
+        SDL_UnlockMutex(pool->mutex);
+    }
+}
+
+static int workerMain(void* data)
+{
+    struct KThreadPoolWorker* worker = data;
+    KThreadPool* pool = worker->pool;
+    // Pool threads shouldn't slow down the main loop
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    while(true)
+    {
+        struct KTask task;
+        if(getTask(pool, worker->index, &task))
+        {
+            runTask(pool, task, worker->index);
+            continue;
+        }
+        SDL_LockMutex(pool->mutex);
+        while(!pool->quit && SDL_AtomicGet(&pool->queued) <= 0)
+            SDL_CondWait(pool->workCond, pool->mutex);
+        bool quit = pool->quit;
+        SDL_UnlockMutex(pool->mutex);
+        if(quit)
+            break;
+    }
+    return 0;
+}
+
+KThreadPool* kthreadpool_create(int threadCount)
+{
+    threadCount = SDL_clamp(threadCount, 1, KTHREADPOOL_MAX_THREADS);
+    KThreadPool* pool = calloc(1,sizeof(KThreadPool));
+    if(!pool)
+        return NULL;
+    pool->deques = calloc(threadCount,sizeof(struct KTaskDeque));
+    pool->mutex = SDL_CreateMutex();
+    pool->workCond = SDL_CreateCond();
+    pool->doneCond = SDL_CreateCond();
+    if(!pool->deques || !pool->mutex || !pool->workCond || !pool->doneCond)
+    {
+        kthreadpool_destroy(pool);
+        return NULL;
+    }
+
+    // Tasks in the deques of threads that couldn't be created are stolen by the other threads
+    pool->threadCount = threadCount;
+    for(int i=1; i<threadCount; i++)
+    {
+        pool->workers[i] = (struct KThreadPoolWorker){pool, i};
+        pool->threads[i] = SDL_CreateThread(workerMain, "KThreadPool", &pool->workers[i]);
+        if(!pool->threads[i])
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR,"kthreadpool_create: Couldn't create thread %d of %d! (%s)",i+1,threadCount,SDL_GetError());
+    }
+    return pool;
+}
+
+int kthreadpool_getThreadCount(const KThreadPool* pool)
+{
+    return pool->threadCount;
+}
+
+bool kthreadpool_submit(KThreadPool* pool, KTaskFunction function, void* data)
+{
+    unsigned int dequeIndex = (unsigned int)SDL_AtomicAdd(&pool->nextDeque, 1) % pool->threadCount;
+    SDL_AtomicAdd(&pool->pending, 1);
+    if(!pushTask(&pool->deques[dequeIndex], (struct KTask){function, data}))
+    {
+        SDL_AtomicAdd(&pool->pending, -1);
+        return false;
+    }
+    SDL_AtomicAdd(&pool->queued, 1);
+    SDL_LockMutex(pool->mutex);
+    SDL_CondSignal(pool->workCond);
+    SDL_UnlockMutex(pool->mutex);
+    return true;
+}
+
+void kthreadpool_wait(KThreadPool* pool)
+{
+    while(true)
+    {
+        struct KTask task;
+        if(getTask(pool, 0, &task))
+        {
+            runTask(pool, task, 0);
+            continue;
+        }
+        SDL_LockMutex(pool->mutex);
+        bool done = (SDL_AtomicGet(&pool->pending) == 0);
+        if(!done && SDL_AtomicGet(&pool->queued) <= 0)
+            SDL_CondWait(pool->doneCond, pool->mutex);
+        SDL_UnlockMutex(pool->mutex);
+        if(done)
+            break;
+    }
+}
+
+void kthreadpool_destroy(KThreadPool* pool)
+{
+    if(!pool)
+        return;
+    if(pool->mutex)
+    {
+        SDL_LockMutex(pool->mutex);
+        pool->quit = true;
+        SDL_CondBroadcast(pool->workCond);
+        SDL_UnlockMutex(pool->mutex);
+    }
+    for(int i=1; i<pool->threadCount; i++)
+    {
+        if(pool->threads[i])
+            SDL_WaitThread(pool->threads[i], NULL);
+    }
+    SDL_DestroyCond(pool->workCond);
+    SDL_DestroyCond(pool->doneCond);
+    SDL_DestroyMutex(pool->mutex);
+    free(pool->deques);
+    free(pool);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdbool.h>
+
+// Max amount of threads in a thread pool
+#define KTHREADPOOL_MAX_THREADS 32
+
+// Max amount of queued tasks per thread
+#define KTHREADPOOL_DEQUE_SIZE 256
+
+typedef struct KThreadPool KThreadPool;
+
+/// @brief Task function run by a thread pool
+/// @param data Task data passed to kthreadpool_submit
+/// @param threadIndex Index of the thread running the task (0 is the thread calling kthreadpool_wait), useful for per-thread data
+typedef void (*KTaskFunction)(void* data, int threadIndex);
+
+/// @brief Create a thread pool. Every thread has its own task deque and steals tasks from the other threads when it runs out of them.
+/// @param threadCount Amount of threads including the thread calling kthreadpool_wait (1 creates no threads, every task is run in kthreadpool_wait)
+/// @return Thread pool or NULL on failure
+KThreadPool* kthreadpool_create(int threadCount);
+
+/// @brief Get the amount of threads of a thread pool
+/// @param pool Thread pool
+/// @return Amount of threads including the thread calling kthreadpool_wait
+int kthreadpool_getThreadCount(const KThreadPool* pool);
+
+/// @brief Queue a task, tasks are spread over the thread deques
+/// @param pool Thread pool
+/// @param function Task function
+/// @param data Task data
+/// @return true on success, false if the task deque is full (the task isn't run)
+bool kthreadpool_submit(KThreadPool* pool, KTaskFunction function, void* data);
+
+/// @brief Run queued tasks on the calling thread until every submitted task is done. Only one thread can wait on a pool at a time.
+/// @param pool Thread pool
+void kthreadpool_wait(KThreadPool* pool);
+
+/// @brief Stop the pool threads and free the pool. Every submitted task has to be done.
+/// @param pool Thread pool (can be NULL)
+void kthreadpool_destroy(KThreadPool* pool);